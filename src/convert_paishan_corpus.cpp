@@ -0,0 +1,214 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "core/binary_paishan_corpus.hpp"
+#include "core/paishan_corpus_reader.hpp"
+#include "core/paishan_reader.hpp"
+#include "core/tile_set.hpp"
+#include "common/throw.hpp"
+#include <boost/lexical_cast.hpp>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <string>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+// Converts paishan one at a time, taking the tile set and the length from the
+// first one. If `length` is not zero, paishan of other lengths are skipped,
+// which picks one kind out of the mixed output of `parse_game_records`.
+class Converter
+{
+public:
+  Converter(
+    std::filesystem::path const &path,
+    IsMajsoulFair::BinaryPaishanEncoding const encoding,
+    std::size_t const length)
+    : path_(path),
+      encoding_(encoding),
+      filter_(length),
+      writer_()
+  {}
+
+  void convert(std::span<std::uint8_t const> const paishan)
+  {
+    if (filter_ != 0u && paishan.size() != filter_) {
+      return;
+    }
+    if (!writer_) {
+      std::uint8_t num_players;
+      if (paishan.size() == IsMajsoulFair::FourPlayerTileSet::num_partial_tiles
+          || paishan.size() == IsMajsoulFair::FourPlayerTileSet::num_tiles) {
+        num_players = 4u;
+      }
+      else if (paishan.size() == IsMajsoulFair::ThreePlayerTileSet::num_partial_tiles
+               || paishan.size() == IsMajsoulFair::ThreePlayerTileSet::num_tiles) {
+        num_players = 3u;
+      }
+      else {
+        IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << paishan.size() << ": An invalid number of tiles.";
+      }
+      writer_.emplace(path_, num_players, paishan.size(), encoding_);
+      num_players_ = num_players;
+      length_ = paishan.size();
+    }
+
+    if (paishan.size() != length_) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+        << paishan.size() << ": Every paishan must be of " << length_
+        << " tiles. Use `--length` to pick one length out of a mixed corpus.";
+    }
+    if (num_players_ == 4u) {
+      IsMajsoulFair::checkPaishan<IsMajsoulFair::FourPlayerTileSet>(paishan);
+    }
+    else {
+      IsMajsoulFair::checkPaishan<IsMajsoulFair::ThreePlayerTileSet>(paishan);
+    }
+    writer_->write(paishan);
+  }
+
+  void close()
+  {
+    if (!writer_ && filter_ != 0u) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << "No paishan of " << filter_ << " tiles to convert.";
+    }
+    if (!writer_) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>("No paishan to convert.");
+    }
+    writer_->close();
+  }
+
+private:
+  std::filesystem::path path_;
+  IsMajsoulFair::BinaryPaishanEncoding encoding_;
+  std::size_t filter_;
+  std::optional<IsMajsoulFair::BinaryPaishanCorpusWriter> writer_;
+  std::uint8_t num_players_ = 0u;
+  std::size_t length_ = 0u;
+}; // class Converter
+
+// The paishan of a line of `parse_game_records`, a JSON object with the
+// member `"paishan":[...]`.
+std::size_t parseGameRecord(std::string_view const line, std::span<std::uint8_t> const row)
+{
+  constexpr std::string_view key = "\"paishan\":[";
+  std::size_t const first = line.find(key);
+  std::size_t const last = first == std::string_view::npos ? first : line.find(']', first);
+  if (last == std::string_view::npos) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << line << ": No paishan.";
+  }
+
+  char const *p = line.data() + first + key.size();
+  char const * const end = line.data() + last;
+  std::size_t length = 0u;
+  while (p != end) {
+    unsigned tile;
+    auto const [q, ec] = std::from_chars(p, end, tile);
+    if (ec != std::errc() || tile >= 37u || length == row.size()) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << line << ": An invalid paishan.";
+    }
+    row[length++] = static_cast<std::uint8_t>(tile);
+    p = q != end && *q == ',' ? q + 1 : q;
+  }
+  return length;
+}
+
+} // namespace <unnamed>
+
+int main(int const argc, char const * const * const argv)
+{
+  std::size_t filter = 0u;
+  int i = 1;
+  if (argc >= 3 && std::string_view(argv[1]) == "--length") {
+    filter = boost::lexical_cast<std::size_t>(argv[2]);
+    if (filter != IsMajsoulFair::FourPlayerTileSet::num_tiles
+        && filter != IsMajsoulFair::FourPlayerTileSet::num_partial_tiles
+        && filter != IsMajsoulFair::ThreePlayerTileSet::num_tiles
+        && filter != IsMajsoulFair::ThreePlayerTileSet::num_partial_tiles) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << filter << ": An invalid number of tiles.";
+    }
+    i += 2;
+  }
+  if (argc - i < 2 || 3 < argc - i) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--length <68|83|108|136>] <PATH TO PAISHAN FILE> <PATH TO BINARY CORPUS> [byte|packed|rank]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::string_view const encoding_name = argc - i == 3 ? argv[i + 2] : "byte";
+  IsMajsoulFair::BinaryPaishanEncoding encoding;
+  if (encoding_name == "byte") {
+    encoding = IsMajsoulFair::BinaryPaishanEncoding::byte_per_tile;
+  }
+  else if (encoding_name == "packed") {
+    encoding = IsMajsoulFair::BinaryPaishanEncoding::packed;
+  }
+  else if (encoding_name == "rank") {
+    // Only for full walls.
+    encoding = IsMajsoulFair::BinaryPaishanEncoding::rank;
+  }
+  else {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << encoding_name << ": An invalid encoding.";
+  }
+
+  std::filesystem::path const path(argv[i]);
+  std::ifstream ifs(path);
+  if (!ifs) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to open.";
+  }
+  // The output of `parse_game_records` is JSON Lines, and that of
+  // `fair_paishan` is comma-separated tiles.
+  bool const json = (ifs >> std::ws).peek() == '{';
+
+  // An uncaught exception may terminate without unwinding the stack, which
+  // would leave the temporary file of the writer behind. Catching it first
+  // destroys the converter, and with it the temporary file.
+  try {
+    Converter converter(argv[i + 1], encoding, filter);
+    std::array<std::uint8_t, IsMajsoulFair::PaishanCorpusReader::max_length> row;
+    if (json) {
+      std::string line;
+      while (std::getline(ifs, line)) {
+        if (line.empty()) {
+          continue;
+        }
+        std::size_t const length = parseGameRecord(line, row);
+        converter.convert(std::span<std::uint8_t const>(row.data(), length));
+      }
+      if (ifs.bad()) {
+        IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to read.";
+      }
+    }
+    else {
+      ifs.close();
+      IsMajsoulFair::PaishanCorpusReader reader(path);
+      while (true) {
+        std::span<std::uint8_t const> const paishan = reader.next();
+        if (paishan.empty()) {
+          break;
+        }
+        converter.convert(paishan);
+      }
+    }
+    converter.close();
+  }
+  catch (...) {
+    throw;
+  }
+}
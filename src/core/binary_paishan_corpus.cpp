@@ -0,0 +1,347 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "binary_paishan_corpus.hpp"
+
+#include "memory_mapped_file.hpp"
+#include "multiset_permutation_rank.hpp"
+#include "tile_set.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+constexpr std::uint16_t version = 1u;
+
+// The rankers of the full walls, built on first use. `rank` and `unrank` are
+// `const`, so they are shared by every reader and writer on every thread.
+IsMajsoulFair::MultisetPermutationRanker const &getRanker(std::uint8_t const num_players)
+{
+  static IsMajsoulFair::MultisetPermutationRanker const four_player_ranker(
+    IsMajsoulFair::FourPlayerTileSet::num_tiles_per_code);
+  static IsMajsoulFair::MultisetPermutationRanker const three_player_ranker(
+    IsMajsoulFair::ThreePlayerTileSet::num_tiles_per_code);
+  return num_players == 3u ? three_player_ranker : four_player_ranker;
+}
+
+std::size_t getNumRankBytes(std::uint8_t const num_players)
+{
+  static std::array<std::size_t, 2u> const num_bytes = []() {
+    std::array<std::size_t, 2u> result;
+    for (std::uint8_t i = 0u; i < 2u; ++i) {
+      IsMajsoulFair::Integer const max_rank = getRanker(3u + i).getNumPermutations() - 1ul;
+      result[i] = (max_rank.bitLength() + 7u) / 8u;
+    }
+    return result;
+  }();
+  return num_bytes[num_players == 3u ? 0u : 1u];
+}
+
+// Whether paishan of `length` tiles can be stored as ranks.
+void checkRankLength(std::uint8_t const num_players, std::size_t const length)
+{
+  std::size_t const full_length = getRanker(num_players).getLength();
+  if (length != full_length) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << length << ": Only full walls of " << full_length << " tiles can be stored as ranks.";
+  }
+}
+
+std::uint64_t loadLittleEndian(char const * const bytes, std::size_t const size) noexcept
+{
+  std::uint64_t result = 0u;
+  for (std::size_t i = size; i > 0u; --i) {
+    result = result << 8u | static_cast<unsigned char>(bytes[i - 1u]);
+  }
+  return result;
+}
+
+void storeLittleEndian(std::uint64_t value, std::size_t const size, char * const bytes) noexcept
+{
+  for (std::size_t i = 0u; i < size; ++i) {
+    bytes[i] = static_cast<char>(value & 0xFFu);
+    value >>= 8u;
+  }
+}
+
+std::array<char, IsMajsoulFair::binary_paishan_corpus_header_size> encodeHeader(
+  IsMajsoulFair::BinaryPaishanCorpusHeader const &header) noexcept
+{
+  std::array<char, IsMajsoulFair::binary_paishan_corpus_header_size> result{};
+  std::copy(
+    IsMajsoulFair::binary_paishan_corpus_magic.cbegin(), IsMajsoulFair::binary_paishan_corpus_magic.cend(),
+    result.begin());
+  storeLittleEndian(version, 2u, result.data() + 8u);
+  storeLittleEndian(static_cast<std::uint8_t>(header.encoding), 1u, result.data() + 10u);
+  storeLittleEndian(header.num_players, 1u, result.data() + 11u);
+  storeLittleEndian(header.length, 2u, result.data() + 12u);
+  storeLittleEndian(header.getRecordSize(), 2u, result.data() + 14u);
+  storeLittleEndian(header.num_paishan, 8u, result.data() + 16u);
+  return result;
+}
+
+} // namespace <unnamed>
+
+namespace IsMajsoulFair{
+
+std::size_t BinaryPaishanCorpusHeader::getRecordSize() const
+{
+  switch (encoding) {
+  case IsMajsoulFair::BinaryPaishanEncoding::packed:
+    return (6u * length + 7u) / 8u;
+  case IsMajsoulFair::BinaryPaishanEncoding::rank:
+    return getNumRankBytes(num_players);
+  default:
+    return length;
+  }
+}
+
+bool isBinaryPaishanCorpus(std::span<char const> const bytes) noexcept
+{
+  return bytes.size() >= IsMajsoulFair::binary_paishan_corpus_magic.size()
+    && std::equal(
+      IsMajsoulFair::binary_paishan_corpus_magic.cbegin(), IsMajsoulFair::binary_paishan_corpus_magic.cend(),
+      bytes.begin());
+}
+
+IsMajsoulFair::BinaryPaishanCorpusHeader readBinaryPaishanCorpusHeader(std::span<char const> const bytes)
+{
+  if (bytes.size() < IsMajsoulFair::binary_paishan_corpus_header_size
+      || !IsMajsoulFair::isBinaryPaishanCorpus(bytes)) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>("Not a binary paishan corpus.");
+  }
+  char const * const data = bytes.data();
+
+  std::uint64_t const file_version = loadLittleEndian(data + 8u, 2u);
+  if (file_version != version) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << file_version << ": An unsupported version.";
+  }
+
+  IsMajsoulFair::BinaryPaishanCorpusHeader header;
+  std::uint64_t const encoding = loadLittleEndian(data + 10u, 1u);
+  if (encoding > static_cast<std::uint8_t>(IsMajsoulFair::BinaryPaishanEncoding::rank)) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << encoding << ": An unknown encoding.";
+  }
+  header.encoding = static_cast<IsMajsoulFair::BinaryPaishanEncoding>(encoding);
+  header.num_players = static_cast<std::uint8_t>(loadLittleEndian(data + 11u, 1u));
+  if (header.num_players != 3u && header.num_players != 4u) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1)
+      << static_cast<unsigned>(header.num_players) << ": An invalid number of players.";
+  }
+  header.length = static_cast<std::uint16_t>(loadLittleEndian(data + 12u, 2u));
+  if (header.length == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>("The paishan must not be empty.");
+  }
+  if (header.encoding == IsMajsoulFair::BinaryPaishanEncoding::rank
+      && header.length != getRanker(header.num_players).getLength()) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << header.length << ": Ranks of partial paishan.";
+  }
+  std::uint64_t const record_size = loadLittleEndian(data + 14u, 2u);
+  if (record_size != header.getRecordSize()) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << record_size << ": An inconsistent record size.";
+  }
+  header.num_paishan = loadLittleEndian(data + 16u, 8u);
+
+  std::size_t const body_size = bytes.size() - IsMajsoulFair::binary_paishan_corpus_header_size;
+  if (body_size / record_size != header.num_paishan || body_size % record_size != 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1)
+      << bytes.size() << ": The size does not match " << header.num_paishan << " records.";
+  }
+
+  return header;
+}
+
+void decodeBinaryPaishanRecord(
+  IsMajsoulFair::BinaryPaishanCorpusHeader const &header, char const * const record, std::span<std::uint8_t> const row)
+{
+  if (row.size() < header.length) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << row.size() << ": Too short a row.";
+  }
+
+  if (header.encoding == IsMajsoulFair::BinaryPaishanEncoding::byte_per_tile) {
+    std::copy(record, record + header.length, reinterpret_cast<char *>(row.data()));
+  }
+  else if (header.encoding == IsMajsoulFair::BinaryPaishanEncoding::rank) {
+    IsMajsoulFair::MultisetPermutationRanker const &ranker = getRanker(header.num_players);
+    IsMajsoulFair::Integer rank;
+    rank.importBits(
+      reinterpret_cast<unsigned char const *>(record), 8u * header.getRecordSize(),
+      IsMajsoulFair::BitOrder::least_significant_first);
+    if (rank >= ranker.getNumPermutations()) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>("A rank out of range.");
+    }
+    std::vector<std::uint_fast8_t> const permutation = ranker.unrank(rank);
+    std::copy(permutation.cbegin(), permutation.cend(), row.begin());
+  }
+  else {
+    // Four codes in every three bytes.
+    for (std::size_t i = 0u; i < header.length; ++i) {
+      std::size_t const bit = 6u * i;
+      unsigned const low = static_cast<unsigned char>(record[bit / 8u]);
+      unsigned const high = bit % 8u > 2u ? static_cast<unsigned char>(record[bit / 8u + 1u]) : 0u;
+      row[i] = static_cast<std::uint8_t>((low | high << 8u) >> (bit % 8u) & 0x3Fu);
+    }
+  }
+
+  for (std::size_t i = 0u; i < header.length; ++i) {
+    if (row[i] >= 37u) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << static_cast<unsigned>(row[i]) << ": An invalid tile.";
+    }
+  }
+}
+
+BinaryPaishanCorpusWriter::BinaryPaishanCorpusWriter(
+  std::filesystem::path const &path,
+  std::uint8_t const num_players,
+  std::size_t const length,
+  IsMajsoulFair::BinaryPaishanEncoding const encoding)
+  : path_(path),
+    temporary_path_(path),
+    ofs_(),
+    header_{encoding, num_players, static_cast<std::uint16_t>(length), 0u},
+    record_(),
+    permutation_()
+{
+  if (num_players != 3u && num_players != 4u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << static_cast<unsigned>(num_players) << ": An invalid number of players.";
+  }
+  if (length == 0u || length > UINT16_MAX) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << length << ": An invalid length.";
+  }
+  if (encoding == IsMajsoulFair::BinaryPaishanEncoding::rank) {
+    checkRankLength(num_players, length);
+  }
+  record_.resize(header_.getRecordSize());
+
+  temporary_path_ += ".tmp";
+  ofs_.open(temporary_path_, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (!ofs_) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << temporary_path_.string() << ": Failed to open.";
+  }
+
+  // A placeholder until `close`.
+  std::array<char, IsMajsoulFair::binary_paishan_corpus_header_size> const bytes = encodeHeader(header_);
+  ofs_.write(bytes.data(), bytes.size());
+}
+
+BinaryPaishanCorpusWriter::~BinaryPaishanCorpusWriter()
+{
+  if (ofs_.is_open()) {
+    ofs_.close();
+    std::error_code error;
+    std::filesystem::remove(temporary_path_, error);
+  }
+}
+
+void BinaryPaishanCorpusWriter::write(std::span<std::uint8_t const> const paishan)
+{
+  if (paishan.size() != header_.length) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << paishan.size() << ": The paishan must be of " << header_.length << " tiles.";
+  }
+  for (std::uint8_t const tile : paishan) {
+    if (tile >= 37u) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << static_cast<unsigned>(tile) << ": An invalid tile.";
+    }
+  }
+
+  if (header_.encoding == IsMajsoulFair::BinaryPaishanEncoding::byte_per_tile) {
+    std::copy(paishan.begin(), paishan.end(), record_.begin());
+  }
+  else if (header_.encoding == IsMajsoulFair::BinaryPaishanEncoding::rank) {
+    // `rank` rejects anything but a permutation of the full wall.
+    permutation_.assign(paishan.begin(), paishan.end());
+    IsMajsoulFair::Integer const rank = getRanker(header_.num_players).rank(permutation_);
+    rank.exportBits(
+      reinterpret_cast<unsigned char *>(record_.data()), 8u * record_.size(),
+      IsMajsoulFair::BitOrder::least_significant_first);
+  }
+  else {
+    std::fill(record_.begin(), record_.end(), 0);
+    for (std::size_t i = 0u; i < paishan.size(); ++i) {
+      std::size_t const bit = 6u * i;
+      unsigned const shifted = static_cast<unsigned>(paishan[i]) << (bit % 8u);
+      record_[bit / 8u] = static_cast<char>(record_[bit / 8u] | (shifted & 0xFFu));
+      if (shifted > 0xFFu) {
+        record_[bit / 8u + 1u] = static_cast<char>(record_[bit / 8u + 1u] | shifted >> 8u);
+      }
+    }
+  }
+
+  ofs_.write(record_.data(), record_.size());
+  if (!ofs_) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path_.string() << ": Failed to write.";
+  }
+  ++header_.num_paishan;
+}
+
+void BinaryPaishanCorpusWriter::close()
+{
+  if (!ofs_.is_open()) {
+    IS_MAJSOUL_FAIR_THROW<std::logic_error>("The corpus has already been closed.");
+  }
+  std::array<char, IsMajsoulFair::binary_paishan_corpus_header_size> const bytes = encodeHeader(header_);
+  ofs_.seekp(0);
+  ofs_.write(bytes.data(), bytes.size());
+  ofs_.close();
+
+  std::error_code error;
+  if (!ofs_) {
+    std::filesystem::remove(temporary_path_, error);
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << temporary_path_.string() << ": Failed to write.";
+  }
+  std::filesystem::rename(temporary_path_, path_, error);
+  if (error) {
+    std::filesystem::remove(temporary_path_, error);
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path_.string() << ": Failed to rename.";
+  }
+}
+
+BinaryPaishanCorpusReader::BinaryPaishanCorpusReader(std::filesystem::path const &path)
+  : file_(path, IsMajsoulFair::MemoryMappedFileAccess::random),
+    header_(IsMajsoulFair::readBinaryPaishanCorpusHeader(file_.getBytes()))
+{}
+
+IsMajsoulFair::BinaryPaishanCorpusHeader const &BinaryPaishanCorpusReader::getHeader() const noexcept
+{
+  return header_;
+}
+
+std::size_t BinaryPaishanCorpusReader::getNumPaishan() const noexcept
+{
+  return header_.num_paishan;
+}
+
+std::size_t BinaryPaishanCorpusReader::getLength() const noexcept
+{
+  return header_.length;
+}
+
+std::size_t BinaryPaishanCorpusReader::read(std::size_t const i, std::span<std::uint8_t> const row) const
+{
+  if (i >= header_.num_paishan) {
+    IS_MAJSOUL_FAIR_THROW<std::out_of_range>(_1) << i << ": Out of range.";
+  }
+  char const * const record
+    = file_.getBytes().data() + IsMajsoulFair::binary_paishan_corpus_header_size + header_.getRecordSize() * i;
+  IsMajsoulFair::decodeBinaryPaishanRecord(header_, record, row);
+  return header_.length;
+}
+
+} // namespace IsMajsoulFair
@@ -0,0 +1,133 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_BINARY_PAISHAN_CORPUS_HPP)
+#define CORE_BINARY_PAISHAN_CORPUS_HPP
+
+#include "memory_mapped_file.hpp"
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// A binary corpus of paishan of one tile set and one length, laid out as a
+// header of `binary_paishan_corpus_header_size` bytes followed by records of
+// a fixed size, so that paishan `i` is at a known offset. All the integers of
+// the header are little-endian.
+//
+//   offset  size  field
+//   0       8     magic, `binary_paishan_corpus_magic`
+//   8       2     version, `1`
+//   10      1     encoding, `BinaryPaishanEncoding`
+//   11      1     number of players of the tile set, `3` or `4`
+//   12      2     number of tiles per paishan
+//   14      2     number of bytes per record
+//   16      8     number of paishan
+//   24      8     reserved, zero
+//
+// With `BinaryPaishanEncoding::byte_per_tile`, a record is the tile codes of
+// a paishan, one byte each. With `BinaryPaishanEncoding::packed`, every code,
+// being less than 64, is packed in 6 bits, least significant first, and the
+// last byte is padded with zeros. With `BinaryPaishanEncoding::rank`, which
+// only holds full walls, a record is the lexicographic rank of the wall among
+// the distinct permutations of its tile set, as computed by
+// `MultisetPermutationRanker`, in the fewest whole bytes that hold the largest
+// rank, least significant byte first. A 136-tile wall takes 136, 102 or 78
+// bytes instead of about 350 in text. All the records of a corpus are of the
+// same size, so the offset of paishan `i` is computed rather than indexed.
+enum class BinaryPaishanEncoding : std::uint8_t
+{
+  byte_per_tile = 0u,
+  packed = 1u,
+  rank = 2u
+}; // enum class BinaryPaishanEncoding
+
+inline constexpr std::array<char, 8u> binary_paishan_corpus_magic{'I', 'M', 'F', 'P', 'A', 'I', 'S', 'H'};
+
+inline constexpr std::size_t binary_paishan_corpus_header_size = 32u;
+
+struct BinaryPaishanCorpusHeader
+{
+  IsMajsoulFair::BinaryPaishanEncoding encoding;
+  std::uint8_t num_players;
+  std::uint16_t length;
+  std::uint64_t num_paishan;
+
+  std::size_t getRecordSize() const;
+}; // struct BinaryPaishanCorpusHeader
+
+// Whether `bytes` begins with the magic of a binary corpus.
+bool isBinaryPaishanCorpus(std::span<char const> bytes) noexcept;
+
+// Parses and validates the header at the beginning of `bytes`, and checks
+// that `bytes` holds exactly the records it declares.
+IsMajsoulFair::BinaryPaishanCorpusHeader readBinaryPaishanCorpusHeader(std::span<char const> bytes);
+
+// Decodes `record` of a paishan of `header.length` tiles into `row`.
+void decodeBinaryPaishanRecord(
+  IsMajsoulFair::BinaryPaishanCorpusHeader const &header, char const *record, std::span<std::uint8_t> row);
+
+// Writes a binary corpus to a temporary file next to `path`. `close` fills in
+// the number of paishan in the header and renames the file to `path`. A writer
+// destroyed without `close`, e.g., by an exception, removes the temporary file
+// instead, so an existing `path` is never replaced by an incomplete corpus.
+class BinaryPaishanCorpusWriter
+{
+public:
+  BinaryPaishanCorpusWriter(
+    std::filesystem::path const &path,
+    std::uint8_t num_players,
+    std::size_t length,
+    IsMajsoulFair::BinaryPaishanEncoding encoding);
+
+  BinaryPaishanCorpusWriter(BinaryPaishanCorpusWriter const &) = delete;
+
+  BinaryPaishanCorpusWriter &operator=(BinaryPaishanCorpusWriter const &) = delete;
+
+  ~BinaryPaishanCorpusWriter();
+
+  void write(std::span<std::uint8_t const> paishan);
+
+  void close();
+
+private:
+  std::filesystem::path path_;
+  std::filesystem::path temporary_path_;
+  std::ofstream ofs_;
+  IsMajsoulFair::BinaryPaishanCorpusHeader header_;
+  std::vector<char> record_;
+  std::vector<std::uint_fast8_t> permutation_;
+}; // class BinaryPaishanCorpusWriter
+
+// Gives random access to the paishan of a binary corpus over a memory mapping.
+// `read` is `const` and touches nothing but the mapping, so it may be called
+// from several threads at once, e.g., on disjoint shards of the corpus.
+class BinaryPaishanCorpusReader
+{
+public:
+  explicit BinaryPaishanCorpusReader(std::filesystem::path const &path);
+
+  IsMajsoulFair::BinaryPaishanCorpusHeader const &getHeader() const noexcept;
+
+  std::size_t getNumPaishan() const noexcept;
+
+  std::size_t getLength() const noexcept;
+
+  // Decodes paishan `i` into `row`, and returns the number of its tiles.
+  std::size_t read(std::size_t i, std::span<std::uint8_t> row) const;
+
+private:
+  IsMajsoulFair::MemoryMappedFile file_;
+  IsMajsoulFair::BinaryPaishanCorpusHeader header_;
+}; // class BinaryPaishanCorpusReader
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_BINARY_PAISHAN_CORPUS_HPP)
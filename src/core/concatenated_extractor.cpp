@@ -0,0 +1,115 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "concatenated_extractor.hpp"
+
+#include "interval_to_binary.hpp"
+#include "covering_binary_interval.hpp"
+#include "interval.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+ConcatenatedExtractor::ConcatenatedExtractor(std::size_t const block_size)
+  : block_size_(block_size),
+    num_paishan_(0u),
+    interval_(),
+    bits_()
+{
+  if (block_size_ == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("The block size must be positive.");
+  }
+}
+
+std::size_t ConcatenatedExtractor::getBlockSize() const noexcept
+{
+  return block_size_;
+}
+
+void ConcatenatedExtractor::push(
+  IsMajsoulFair::Interval const &interval, IsMajsoulFair::IntegerRandomState &state)
+{
+  // `[L, U) / D` narrowed by `[a, b) / d` is
+  // `[L d + (U - L) a, L d + (U - L) b) / (D d)`.
+  IsMajsoulFair::Integer const width = interval_.getUpperNumerator() - interval_.getLowerNumerator();
+  IsMajsoulFair::Integer lower_numerator = interval_.getLowerNumerator() * interval.getDenominator();
+  IsMajsoulFair::Integer upper_numerator = lower_numerator;
+  lower_numerator.addmul(width, interval.getLowerNumerator());
+  upper_numerator.addmul(width, interval.getUpperNumerator());
+  IsMajsoulFair::Integer const denominator = interval_.getDenominator() * interval.getDenominator();
+  interval_.assign(denominator, lower_numerator, upper_numerator);
+
+  emit_();
+
+  if (++num_paishan_ == block_size_) {
+    finish(state);
+  }
+}
+
+void ConcatenatedExtractor::finish(IsMajsoulFair::IntegerRandomState &state)
+{
+  if (num_paishan_ == 0u) {
+    return;
+  }
+
+  std::size_t const num_bits = IsMajsoulFair::getMaxNumBitsWithinTwoWords(interval_);
+  std::vector<unsigned char> const binary = IsMajsoulFair::intervalToBinary(interval_, num_bits, state);
+  bits_.insert(bits_.cend(), binary.cbegin(), binary.cend());
+
+  num_paishan_ = 0u;
+  interval_ = IsMajsoulFair::Interval();
+}
+
+void ConcatenatedExtractor::takeBits(std::vector<unsigned char> &bits)
+{
+  bits.insert(bits.cend(), bits_.cbegin(), bits_.cend());
+  bits_.clear();
+}
+
+void ConcatenatedExtractor::emit_()
+{
+  // At `floor(log2(D / (U - L)))` bits the interval is covered by one or two
+  // words, and one word at the next width is too narrow to cover it. With
+  // two words `w` and `w + 1`, the determined bits are the prefix they share,
+  // which ends above the trailing ones of `w`.
+  IsMajsoulFair::Integer const width = interval_.getUpperNumerator() - interval_.getLowerNumerator();
+  std::size_t num_bits = (interval_.getDenominator() / width).bitLength() - 1u;
+  if (num_bits == 0u) {
+    return;
+  }
+  auto [lower_binary, upper_binary] = IsMajsoulFair::getCoveringBinaryInterval(interval_, num_bits);
+  if (upper_binary - lower_binary != 1ul) {
+    if (upper_binary - lower_binary != 2ul) {
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    }
+    std::size_t num_trailing_ones = 0u;
+    while (lower_binary.testBit(num_trailing_ones)) {
+      ++num_trailing_ones;
+    }
+    if (num_trailing_ones + 1u >= num_bits) {
+      return;
+    }
+    lower_binary >>= num_trailing_ones + 1u;
+    num_bits -= num_trailing_ones + 1u;
+  }
+
+  for (std::size_t i = num_bits; i > 0u; --i) {
+    bits_.push_back(lower_binary.testBit(i - 1u) ? 1u : 0u);
+  }
+
+  // Zooms into the word: `x -> x 2^k - w`.
+  IsMajsoulFair::Integer const offset = lower_binary * interval_.getDenominator();
+  IsMajsoulFair::Integer lower_numerator = interval_.getLowerNumerator() << num_bits;
+  lower_numerator -= offset;
+  IsMajsoulFair::Integer upper_numerator = interval_.getUpperNumerator() << num_bits;
+  upper_numerator -= offset;
+  interval_.assign(interval_.getDenominator(), lower_numerator, upper_numerator);
+}
+
+} // namespace IsMajsoulFair
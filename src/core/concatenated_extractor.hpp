@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_CONCATENATED_EXTRACTOR_HPP)
+#define CORE_CONCATENATED_EXTRACTOR_HPP
+
+#include "interval.hpp"
+#include "integer.hpp"
+#include <vector>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// Extracts bits from a sequence of paishan taken as one mixed-radix number,
+// instead of from every paishan on its own. A running interval of `[0, 1)` is
+// narrowed by the interval of every paishan in turn, as a streaming arithmetic
+// decoder would, and the leading bits shared by every point of it are emitted
+// as soon as they are determined.
+//
+// The denominator of the running interval is the product of those of the
+// paishan, so it is bounded by settling the interval every `block_size`
+// paishan: the rest of the interval is extracted as by
+// `intervalToBinary(interval, getMaxNumBitsWithinTwoWords(interval), state)`,
+// and the interval starts over. The number of the bits of a block is within
+// one bit of its information, `-log2` of the width of its interval, since at
+// most one choice between two words is drawn from `state` per block rather
+// than per paishan. Since the number of the bits of a block depends on the
+// paishan in it, the output is the concatenation of variable-length records
+// without their lengths.
+class ConcatenatedExtractor
+{
+public:
+  explicit ConcatenatedExtractor(std::size_t block_size);
+
+  std::size_t getBlockSize() const noexcept;
+
+  // Narrows the running interval by the interval of the next paishan, and
+  // settles the block when it is full.
+  void push(IsMajsoulFair::Interval const &interval, IsMajsoulFair::IntegerRandomState &state);
+
+  // Settles the block of the paishan pushed so far, if any.
+  void finish(IsMajsoulFair::IntegerRandomState &state);
+
+  // Moves the bits emitted so far, one bit per element, most significant
+  // first, to the back of `bits`.
+  void takeBits(std::vector<unsigned char> &bits);
+
+private:
+  void emit_();
+
+  std::size_t block_size_;
+  std::size_t num_paishan_;
+  IsMajsoulFair::Interval interval_;
+  std::vector<unsigned char> bits_;
+}; // class ConcatenatedExtractor
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_CONCATENATED_EXTRACTOR_HPP)
@@ -7,14 +7,59 @@
 
 #include "interval.hpp"
 #include "integer.hpp"
+#include "../common/throw.hpp"
 #include <utility>
+#include <stdexcept>
 #include <cstddef>
 
 
 namespace IsMajsoulFair{
 
-std::pair<IsMajsoulFair::Integer, IsMajsoulFair::Integer> getCoveringBinaryInterval(
-  IsMajsoulFair::Interval const &interval, std::size_t const num_bits);
+template<typename IntegerType>
+std::pair<IntegerType, IntegerType> getCoveringBinaryInterval(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval, std::size_t const num_bits)
+{
+  // The largest `lower` with `lower / 2^num_bits <= L / D` and the smallest
+  // `upper` with `upper / 2^num_bits >= U / D`.
+  IntegerType const lower_binary = (interval.getLowerNumerator() << num_bits) / interval.getDenominator();
+  IntegerType upper_binary = interval.getUpperNumerator() << num_bits;
+  upper_binary += interval.getDenominator();
+  upper_binary -= 1ul;
+  upper_binary /= interval.getDenominator();
+  if (lower_binary.bitLength() > num_bits) {
+    IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+  }
+
+  return {lower_binary, upper_binary};
+}
+
+// Returns the largest `num_bits` for which `getCoveringBinaryInterval(interval,
+// num_bits)` covers at most two words. The number of the covering words never
+// decreases with `num_bits`, and it is at most two while `2^num_bits` does not
+// exceed `D / (U - L)`, but more than two once `2^num_bits` exceeds twice it,
+// so only the one width in between has to be tried.
+template<typename IntegerType>
+std::size_t getMaxNumBitsWithinTwoWords(IsMajsoulFair::BasicInterval<IntegerType> const &interval)
+{
+  IntegerType const width = interval.getUpperNumerator() - interval.getLowerNumerator();
+  if (width == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("The interval must not be empty.");
+  }
+
+  // `floor(log2(D / (U - L)))`.
+  std::size_t const num_bits = (interval.getDenominator() / width).bitLength() - 1u;
+
+  auto const [lower_binary, upper_binary] = IsMajsoulFair::getCoveringBinaryInterval(interval, num_bits + 1u);
+  if (upper_binary - lower_binary <= 2ul) {
+    return num_bits + 1u;
+  }
+  return num_bits;
+}
+
+extern template std::pair<IsMajsoulFair::Integer, IsMajsoulFair::Integer> getCoveringBinaryInterval(
+  IsMajsoulFair::Interval const &interval, std::size_t num_bits);
+
+extern template std::size_t getMaxNumBitsWithinTwoWords(IsMajsoulFair::Interval const &interval);
 
 } // namespace IsMajsoulFair
 
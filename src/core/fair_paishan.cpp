@@ -1,80 +1,151 @@
 #include "fair_paishan.hpp"
 
+#include "multiset_permutation_rank.hpp"
+#include "uniform_integer_sampler.hpp"
+#include "tile_set.hpp"
+#include "integer.hpp"
 #include "../common/throw.hpp"
 #include <random>
+#include <istream>
 #include <algorithm>
 #include <vector>
+#include <functional>
 #include <stdexcept>
 #include <cstdint>
+#include <cstddef>
 
 
+namespace{
+
+using std::placeholders::_1;
+
+template<typename TileSet>
+IsMajsoulFair::MultisetPermutationRanker const &getRanker()
+{
+  static IsMajsoulFair::MultisetPermutationRanker const ranker(TileSet::num_tiles_per_code);
+  return ranker;
+}
+
+template<typename TileSet>
+std::size_t getRankBits()
+{
+  static std::size_t const num_bits = (getRanker<TileSet>().getNumPermutations() - 1ul).bitLength();
+  return num_bits;
+}
+
+template<typename TileSet>
+void checkNumTiles(std::uint_fast8_t const num_tiles)
+{
+  if (num_tiles > TileSet::num_tiles) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << static_cast<unsigned>(num_tiles) << ": The number of tiles is out of range.";
+  }
+}
+
+} // namespace *unnamed*
+
 namespace IsMajsoulFair{
 
+template<typename TileSet>
 std::vector<std::uint_fast8_t> generateFairPaishan(
   std::mt19937 &random_number_engine,
   std::uint_fast8_t const num_tiles)
 {
-  std::vector<std::uint_fast8_t> paishan(136u, 0u);
-  std::iota(paishan.begin(), paishan.end(), 0u);
+  checkNumTiles<TileSet>(num_tiles);
+
+  // Shuffling the codes of the tile ids is the same as shuffling the ids and
+  // then mapping them to their codes.
+  std::vector<std::uint_fast8_t> paishan(TileSet::id_to_code.cbegin(), TileSet::id_to_code.cend());
   std::shuffle(paishan.begin(), paishan.end(), random_number_engine);
 
-  for (std::uint_fast8_t &tile : paishan) {
-    if (0u <= tile && tile < 16u) {
-      // 1m, 2m, 3m, 4m
-      tile /= 4u;
-      tile += 1u;
-      continue;
-    }
-    if (tile == 16u) {
-      // 0m
-      tile = 0u;
-      continue;
-    }
-    if (16u < tile && tile < 36u) {
-      // 5m, 6m, 7m, 8m, 9m
-      tile /= 4u;
-      tile += 1u;
-      continue;
-    }
-    if (36u <= tile && tile < 52u) {
-      // 1p, 2p, 3p, 4p
-      tile /= 4u;
-      tile += 2u;
-      continue;
-    }
-    if (tile == 52u) {
-      // 0p
-      tile = 10u;
-      continue;
-    }
-    if (52u < tile && tile < 72u) {
-      // 5p, 6p, 7p, 8p, 9p
-      tile /= 4u;
-      tile += 2u;
-      continue;
-    }
-    if (72u <= tile && tile < 88u) {
-      // 1s, 2s, 3s, 4s
-      tile /= 4u;
-      tile += 3u;
-      continue;
-    }
-    if (tile == 88u) {
-      // 0s
-      tile = 20u;
-      continue;
-    }
-    if (88u < tile) {
-      // 5s, 6s, 7s, 8s, 9s, 1z, 2z, 3z, 4z, 5z, 6z, 7z
-      tile /= 4u;
-      tile += 3u;
-      continue;
+  paishan.resize(num_tiles);
+  return paishan;
+}
+
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  std::mt19937 &random_number_engine,
+  std::uint_fast8_t const num_tiles)
+{
+  return IsMajsoulFair::generateFairPaishan<IsMajsoulFair::FourPlayerTileSet>(random_number_engine, num_tiles);
+}
+
+template<typename TileSet>
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  IsMajsoulFair::IntegerRandomState &state,
+  std::uint_fast8_t const num_tiles)
+{
+  checkNumTiles<TileSet>(num_tiles);
+
+  static IsMajsoulFair::UniformIntegerSampler const sampler(getRanker<TileSet>().getNumPermutations());
+
+  IsMajsoulFair::Integer rank;
+  sampler.sample(state, rank);
+  std::vector<std::uint_fast8_t> paishan = getRanker<TileSet>().unrank(rank);
+  paishan.resize(num_tiles);
+  return paishan;
+}
+
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  IsMajsoulFair::IntegerRandomState &state,
+  std::uint_fast8_t const num_tiles)
+{
+  return IsMajsoulFair::generateFairPaishan<IsMajsoulFair::FourPlayerTileSet>(state, num_tiles);
+}
+
+template<typename TileSet>
+std::size_t getFairPaishanRecordSize()
+{
+  return (getRankBits<TileSet>() + 7u) / 8u;
+}
+
+std::size_t getFairPaishanRecordSize()
+{
+  return IsMajsoulFair::getFairPaishanRecordSize<IsMajsoulFair::FourPlayerTileSet>();
+}
+
+template<typename TileSet>
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  std::istream &bitstream,
+  std::uint_fast8_t const num_tiles)
+{
+  checkNumTiles<TileSet>(num_tiles);
+
+  std::vector<unsigned char> record(IsMajsoulFair::getFairPaishanRecordSize<TileSet>());
+  IsMajsoulFair::Integer rank;
+  do {
+    bitstream.read(reinterpret_cast<char *>(record.data()), record.size());
+    if (bitstream.gcount() != static_cast<std::streamsize>(record.size())) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>("The bitstream ran out.");
     }
-    IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
-  }
+    rank.importBits(record.data(), getRankBits<TileSet>(), IsMajsoulFair::BitOrder::most_significant_first);
+  } while (rank >= getRanker<TileSet>().getNumPermutations());
 
+  std::vector<std::uint_fast8_t> paishan = getRanker<TileSet>().unrank(rank);
   paishan.resize(num_tiles);
   return paishan;
 }
 
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  std::istream &bitstream,
+  std::uint_fast8_t const num_tiles)
+{
+  return IsMajsoulFair::generateFairPaishan<IsMajsoulFair::FourPlayerTileSet>(bitstream, num_tiles);
+}
+
+template std::vector<std::uint_fast8_t> generateFairPaishan<IsMajsoulFair::FourPlayerTileSet>(
+  std::mt19937 &random_number_engine, std::uint_fast8_t num_tiles);
+template std::vector<std::uint_fast8_t> generateFairPaishan<IsMajsoulFair::FourPlayerTileSet>(
+  IsMajsoulFair::IntegerRandomState &state, std::uint_fast8_t num_tiles);
+template std::size_t getFairPaishanRecordSize<IsMajsoulFair::FourPlayerTileSet>();
+template std::vector<std::uint_fast8_t> generateFairPaishan<IsMajsoulFair::FourPlayerTileSet>(
+  std::istream &bitstream, std::uint_fast8_t num_tiles);
+
+template std::vector<std::uint_fast8_t> generateFairPaishan<IsMajsoulFair::ThreePlayerTileSet>(
+  std::mt19937 &random_number_engine, std::uint_fast8_t num_tiles);
+template std::vector<std::uint_fast8_t> generateFairPaishan<IsMajsoulFair::ThreePlayerTileSet>(
+  IsMajsoulFair::IntegerRandomState &state, std::uint_fast8_t num_tiles);
+template std::size_t getFairPaishanRecordSize<IsMajsoulFair::ThreePlayerTileSet>();
+template std::vector<std::uint_fast8_t> generateFairPaishan<IsMajsoulFair::ThreePlayerTileSet>(
+  std::istream &bitstream, std::uint_fast8_t num_tiles);
+
 } // namespace IsMajsoulFair
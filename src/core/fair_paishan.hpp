@@ -1,17 +1,61 @@
 #if !defined(CORE_FAIR_PAISHAN_HPP_INCLUDE_GUARD)
 #define CORE_FAIR_PAISHAN_HPP_INCLUDE_GUARD
 
+#include "integer.hpp"
 #include <random>
+#include <iosfwd>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 
 namespace IsMajsoulFair{
 
+// The overloads taking a tile set `TileSet`, e.g., `ThreePlayerTileSet`,
+// generate walls of it, and are explicitly instantiated for the tile sets of
+// `tile_set.hpp`. The others generate four-player walls.
+
+template<typename TileSet>
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  std::mt19937 &random_number_engine,
+  std::uint_fast8_t const num_tiles);
+
 std::vector<std::uint_fast8_t> generateFairPaishan(
   std::mt19937 &random_number_engine,
   std::uint_fast8_t const num_tiles);
 
+// Draws a paishan uniformly from the distinct ones by unranking an integer
+// drawn uniformly below the number of them.
+template<typename TileSet>
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  IsMajsoulFair::IntegerRandomState &state,
+  std::uint_fast8_t const num_tiles);
+
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  IsMajsoulFair::IntegerRandomState &state,
+  std::uint_fast8_t const num_tiles);
+
+// The number of bytes of `bitstream` consumed by each attempt of the overload
+// below.
+template<typename TileSet>
+std::size_t getFairPaishanRecordSize();
+
+std::size_t getFairPaishanRecordSize();
+
+// The same as above, but the integer is read from `bitstream`. Each attempt
+// reads a record of `getFairPaishanRecordSize()` bytes and takes its leading
+// bits, most significant first, as just wide enough for the largest rank.
+// Records that are not valid ranks are skipped, so that a recorded bitstream
+// replays the same paishans.
+template<typename TileSet>
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  std::istream &bitstream,
+  std::uint_fast8_t const num_tiles);
+
+std::vector<std::uint_fast8_t> generateFairPaishan(
+  std::istream &bitstream,
+  std::uint_fast8_t const num_tiles);
+
 } // namespace IsMajsoulFair
 
 #endif // !defined(CORE_FAIR_PAISHAN_HPP_INCLUDE_GUARD)
@@ -0,0 +1,976 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_FIXED_INTEGER_HPP)
+#define CORE_FIXED_INTEGER_HPP
+
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <gmp.h>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+#include <climits>
+#include <cmath>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// A non-negative integer of at least `Bits` bits whose limbs live in the
+// object itself. Arithmetic never allocates; results that do not fit
+// throw `std::overflow_error`, and results that would be negative throw
+// `std::underflow_error`.
+template<std::size_t Bits>
+class FixedInteger
+{
+private:
+  static_assert(Bits >= 1u);
+
+  static constexpr mp_size_t num_limbs_ = (Bits + GMP_NUMB_BITS - 1u) / GMP_NUMB_BITS;
+
+public:
+  FixedInteger() noexcept
+    : size_(0)
+  {}
+
+  explicit FixedInteger(unsigned long const value) noexcept
+    : size_(0)
+  {
+    setLimb_(value);
+  }
+
+  explicit FixedInteger(long const value)
+    : size_(0)
+  {
+    if (value < 0) {
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    setLimb_(static_cast<unsigned long>(value));
+  }
+
+  FixedInteger(FixedInteger const &other) noexcept
+    : size_(other.size_)
+  {
+    std::copy_n(other.limbs_.data(), size_, limbs_.data());
+  }
+
+  void swap(FixedInteger &other) noexcept
+  {
+    FixedInteger tmp(other);
+    other = *this;
+    *this = tmp;
+  }
+
+  void swap(FixedInteger &&other) noexcept
+  {
+    swap(other);
+  }
+
+  FixedInteger &operator=(FixedInteger const &other) noexcept
+  {
+    size_ = other.size_;
+    std::copy_n(other.limbs_.data(), size_, limbs_.data());
+    return *this;
+  }
+
+  FixedInteger &operator=(unsigned long const value) noexcept
+  {
+    setLimb_(value);
+    return *this;
+  }
+
+  FixedInteger &operator=(long const value)
+  {
+    return *this = FixedInteger(value);
+  }
+
+  FixedInteger &operator++()
+  {
+    return *this += 1ul;
+  }
+
+  FixedInteger operator++(int)
+  {
+    FixedInteger result(*this);
+    ++*this;
+    return result;
+  }
+
+  FixedInteger &operator--()
+  {
+    return *this -= 1ul;
+  }
+
+  FixedInteger operator--(int)
+  {
+    FixedInteger result(*this);
+    --*this;
+    return result;
+  }
+
+  FixedInteger &operator+=(FixedInteger const &rhs)
+  {
+    if (rhs.size_ == 0) {
+      return *this;
+    }
+    if (size_ == 0) {
+      return *this = rhs;
+    }
+    mp_limb_t carry;
+    if (size_ >= rhs.size_) {
+      carry = mpn_add(limbs_.data(), limbs_.data(), size_, rhs.limbs_.data(), rhs.size_);
+    }
+    else {
+      carry = mpn_add(limbs_.data(), rhs.limbs_.data(), rhs.size_, limbs_.data(), size_);
+      size_ = rhs.size_;
+    }
+    pushCarry_(carry);
+    return *this;
+  }
+
+  FixedInteger &operator+=(unsigned long const rhs)
+  {
+    if (size_ == 0) {
+      setLimb_(rhs);
+      return *this;
+    }
+    pushCarry_(mpn_add_1(limbs_.data(), limbs_.data(), size_, rhs));
+    return *this;
+  }
+
+  FixedInteger operator+(FixedInteger const &rhs) const
+  {
+    return FixedInteger(*this) += rhs;
+  }
+
+  FixedInteger operator+(unsigned long const rhs) const
+  {
+    return FixedInteger(*this) += rhs;
+  }
+
+  FixedInteger &operator-=(FixedInteger const &rhs)
+  {
+    if (*this < rhs) {
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    if (rhs.size_ == 0) {
+      return *this;
+    }
+    mpn_sub(limbs_.data(), limbs_.data(), size_, rhs.limbs_.data(), rhs.size_);
+    normalize_();
+    return *this;
+  }
+
+  FixedInteger &operator-=(unsigned long const rhs)
+  {
+    if (*this < rhs) {
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    if (size_ == 0) {
+      return *this;
+    }
+    mpn_sub_1(limbs_.data(), limbs_.data(), size_, rhs);
+    normalize_();
+    return *this;
+  }
+
+  FixedInteger operator-(FixedInteger const &rhs) const
+  {
+    return FixedInteger(*this) -= rhs;
+  }
+
+  FixedInteger operator-(unsigned long const rhs) const
+  {
+    return FixedInteger(*this) -= rhs;
+  }
+
+  FixedInteger &operator*=(FixedInteger const &rhs)
+  {
+    if (size_ == 0 || rhs.size_ == 0) {
+      size_ = 0;
+      return *this;
+    }
+    std::array<mp_limb_t, 2u * num_limbs_> product;
+    mp_size_t const product_size = multiply_(*this, rhs, product);
+    if (product_size > num_limbs_) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    size_ = product_size;
+    std::copy_n(product.data(), size_, limbs_.data());
+    return *this;
+  }
+
+  FixedInteger &operator*=(unsigned long const rhs)
+  {
+    if (size_ == 0 || rhs == 0u) {
+      size_ = 0;
+      return *this;
+    }
+    pushCarry_(mpn_mul_1(limbs_.data(), limbs_.data(), size_, rhs));
+    return *this;
+  }
+
+  FixedInteger &operator*=(long const rhs)
+  {
+    if (rhs < 0 && size_ != 0) {
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    return *this *= static_cast<unsigned long>(rhs < 0 ? 0 : rhs);
+  }
+
+  FixedInteger operator*(FixedInteger const &rhs) const
+  {
+    return FixedInteger(*this) *= rhs;
+  }
+
+  FixedInteger operator*(unsigned long const rhs) const
+  {
+    return FixedInteger(*this) *= rhs;
+  }
+
+  FixedInteger operator*(long const rhs) const
+  {
+    return FixedInteger(*this) *= rhs;
+  }
+
+  FixedInteger &operator/=(FixedInteger const &rhs)
+  {
+    FixedInteger remainder;
+    divide_(rhs, *this, remainder);
+    return *this;
+  }
+
+  FixedInteger &operator/=(unsigned long const rhs)
+  {
+    if (rhs == 0u) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
+    }
+    if (size_ == 0) {
+      return *this;
+    }
+    mpn_divrem_1(limbs_.data(), 0, limbs_.data(), size_, rhs);
+    normalize_();
+    return *this;
+  }
+
+  FixedInteger operator/(FixedInteger const &rhs) const
+  {
+    return FixedInteger(*this) /= rhs;
+  }
+
+  FixedInteger operator/(unsigned long const rhs) const
+  {
+    return FixedInteger(*this) /= rhs;
+  }
+
+  FixedInteger &operator%=(FixedInteger const &rhs)
+  {
+    FixedInteger quotient;
+    divide_(rhs, quotient, *this);
+    return *this;
+  }
+
+  FixedInteger &operator%=(unsigned long const rhs)
+  {
+    if (rhs == 0u) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
+    }
+    if (size_ == 0) {
+      return *this;
+    }
+    setLimb_(mpn_mod_1(limbs_.data(), size_, rhs));
+    return *this;
+  }
+
+  FixedInteger operator%(FixedInteger const &rhs) const
+  {
+    return FixedInteger(*this) %= rhs;
+  }
+
+  FixedInteger operator%(unsigned long const rhs) const
+  {
+    return FixedInteger(*this) %= rhs;
+  }
+
+  FixedInteger &addmul(FixedInteger const &lhs, FixedInteger const &rhs)
+  {
+    if (lhs.size_ == 0 || rhs.size_ == 0) {
+      return *this;
+    }
+    std::array<mp_limb_t, 2u * num_limbs_> product;
+    mp_size_t const product_size = multiply_(lhs, rhs, product);
+    if (product_size > num_limbs_) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    mp_limb_t carry;
+    if (size_ >= product_size) {
+      carry = mpn_add(limbs_.data(), limbs_.data(), size_, product.data(), product_size);
+    }
+    else {
+      carry = mpn_add(limbs_.data(), product.data(), product_size, limbs_.data(), size_);
+      size_ = product_size;
+    }
+    pushCarry_(carry);
+    return *this;
+  }
+
+  FixedInteger &addmul(FixedInteger const &lhs, unsigned long const rhs)
+  {
+    if (lhs.size_ == 0 || rhs == 0u) {
+      return *this;
+    }
+    if (&lhs == this) {
+      return addmul(FixedInteger(lhs), rhs);
+    }
+    if (size_ < lhs.size_) {
+      std::fill(limbs_.data() + size_, limbs_.data() + lhs.size_, mp_limb_t(0u));
+      size_ = lhs.size_;
+    }
+    mp_limb_t carry = mpn_addmul_1(limbs_.data(), lhs.limbs_.data(), lhs.size_, rhs);
+    if (carry != 0u && size_ > lhs.size_) {
+      carry = mpn_add_1(
+        limbs_.data() + lhs.size_, limbs_.data() + lhs.size_, size_ - lhs.size_, carry);
+    }
+    pushCarry_(carry);
+    return *this;
+  }
+
+  FixedInteger &submul(FixedInteger const &lhs, FixedInteger const &rhs)
+  {
+    if (lhs.size_ == 0 || rhs.size_ == 0) {
+      return *this;
+    }
+    std::array<mp_limb_t, 2u * num_limbs_> product;
+    mp_size_t const product_size = multiply_(lhs, rhs, product);
+    if (product_size > size_ || (product_size == size_ && mpn_cmp(limbs_.data(), product.data(), size_) < 0)) {
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    mpn_sub(limbs_.data(), limbs_.data(), size_, product.data(), product_size);
+    normalize_();
+    return *this;
+  }
+
+  FixedInteger &submul(FixedInteger const &lhs, unsigned long const rhs)
+  {
+    if (lhs.size_ == 0 || rhs == 0u) {
+      return *this;
+    }
+    if (&lhs == this) {
+      return submul(FixedInteger(lhs), rhs);
+    }
+    if (size_ < lhs.size_) {
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    mp_limb_t borrow = mpn_submul_1(limbs_.data(), lhs.limbs_.data(), lhs.size_, rhs);
+    if (borrow != 0u && size_ > lhs.size_) {
+      borrow = mpn_sub_1(limbs_.data() + lhs.size_, limbs_.data() + lhs.size_, size_ - lhs.size_, borrow);
+    }
+    if (borrow != 0u) {
+      // Adding the product back modulo `2^(GMP_NUMB_BITS size_)` restores the
+      // value, so that a failure leaves `*this` unchanged.
+      mp_limb_t const carry = mpn_addmul_1(limbs_.data(), lhs.limbs_.data(), lhs.size_, rhs);
+      if (size_ > lhs.size_) {
+        mpn_add_1(limbs_.data() + lhs.size_, limbs_.data() + lhs.size_, size_ - lhs.size_, carry);
+      }
+      IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
+    }
+    normalize_();
+    return *this;
+  }
+
+  void reserve(std::size_t const bits) const
+  {
+    if (bits > Bits) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("`bits` exceeds the fixed width.");
+    }
+  }
+
+  FixedInteger &inplacePow(unsigned long exponent)
+  {
+    FixedInteger base(*this);
+    setLimb_(1u);
+    while (exponent != 0u) {
+      if ((exponent & 1u) != 0u) {
+        *this *= base;
+      }
+      exponent >>= 1u;
+      if (exponent != 0u) {
+        base *= base;
+      }
+    }
+    return *this;
+  }
+
+  FixedInteger pow(unsigned long const exponent) const
+  {
+    return FixedInteger(*this).inplacePow(exponent);
+  }
+
+  FixedInteger &operator<<=(std::size_t const shift)
+  {
+    if (size_ == 0) {
+      return *this;
+    }
+    std::size_t const limb_shift = shift / GMP_NUMB_BITS;
+    unsigned const bit_shift = shift % GMP_NUMB_BITS;
+    if (limb_shift + size_ > num_limbs_) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    mp_limb_t carry = 0u;
+    if (bit_shift != 0u) {
+      carry = mpn_lshift(limbs_.data() + limb_shift, limbs_.data(), size_, bit_shift);
+    }
+    else {
+      std::copy_backward(limbs_.data(), limbs_.data() + size_, limbs_.data() + size_ + limb_shift);
+    }
+    std::fill_n(limbs_.data(), limb_shift, mp_limb_t(0u));
+    size_ += limb_shift;
+    pushCarry_(carry);
+    return *this;
+  }
+
+  FixedInteger operator<<(std::size_t const shift) const
+  {
+    return FixedInteger(*this) <<= shift;
+  }
+
+  FixedInteger &operator>>=(std::size_t const shift) noexcept
+  {
+    std::size_t const limb_shift = shift / GMP_NUMB_BITS;
+    unsigned const bit_shift = shift % GMP_NUMB_BITS;
+    if (limb_shift >= static_cast<std::size_t>(size_)) {
+      size_ = 0;
+      return *this;
+    }
+    mp_size_t const new_size = size_ - limb_shift;
+    if (bit_shift != 0u) {
+      mpn_rshift(limbs_.data(), limbs_.data() + limb_shift, new_size, bit_shift);
+    }
+    else {
+      std::copy_n(limbs_.data() + limb_shift, new_size, limbs_.data());
+    }
+    size_ = new_size;
+    normalize_();
+    return *this;
+  }
+
+  FixedInteger operator>>(std::size_t const shift) const noexcept
+  {
+    return FixedInteger(*this) >>= shift;
+  }
+
+  std::size_t bitLength() const noexcept
+  {
+    if (size_ == 0) {
+      return 0u;
+    }
+    return static_cast<std::size_t>(size_) * GMP_NUMB_BITS - __builtin_clzl(limbs_[size_ - 1]);
+  }
+
+  bool testBit(std::size_t const index) const noexcept
+  {
+    std::size_t const limb_index = index / GMP_NUMB_BITS;
+    return limb_index < static_cast<std::size_t>(size_)
+      && (limbs_[limb_index] >> (index % GMP_NUMB_BITS) & 1u) != 0u;
+  }
+
+  void exportBits(unsigned char * const buffer, std::size_t const num_bits, BitOrder const order) const
+  {
+    if (bitLength() > num_bits) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`num_bits` is too small to hold the integer.");
+    }
+    std::size_t const num_bytes = (num_bits + 7u) / 8u;
+    if (order == BitOrder::least_significant_first) {
+      for (std::size_t i = 0u; i < num_bytes; ++i) {
+        buffer[i] = getByte_(8u * i);
+      }
+      return;
+    }
+    std::size_t const padding = num_bytes * 8u - num_bits;
+    for (std::size_t i = 0u; i < num_bytes; ++i) {
+      std::size_t const position = 8u * (num_bytes - 1u - i);
+      buffer[i] = position == 0u
+        ? static_cast<unsigned char>(getByte_(0u) << padding) : getByte_(position - padding);
+    }
+  }
+
+  FixedInteger &importBits(unsigned char const * const buffer, std::size_t const num_bits, BitOrder const order)
+  {
+    std::size_t const num_bytes = (num_bits + 7u) / 8u;
+    limbs_.fill(0u);
+    size_ = num_limbs_;
+    if (order == BitOrder::least_significant_first) {
+      for (std::size_t i = 0u; i < num_bytes; ++i) {
+        unsigned char byte = buffer[i];
+        if (i + 1u == num_bytes && num_bits % 8u != 0u) {
+          byte &= (1u << num_bits % 8u) - 1u;
+        }
+        orByte_(8u * i, byte);
+      }
+    }
+    else {
+      std::size_t const padding = num_bytes * 8u - num_bits;
+      for (std::size_t i = 0u; i < num_bytes; ++i) {
+        std::size_t const position = 8u * (num_bytes - 1u - i);
+        if (position == 0u) {
+          orByte_(0u, buffer[i] >> padding);
+        }
+        else {
+          orByte_(position - padding, buffer[i]);
+        }
+      }
+    }
+    normalize_();
+    return *this;
+  }
+
+  FixedInteger &setToRandom(IsMajsoulFair::IntegerRandomState &state, FixedInteger const &upper)
+  {
+    if (upper <= 0ul) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`upper` must be positive.");
+    }
+    mp_limb_t const top_mask = [&]() -> mp_limb_t {
+      mp_limb_t const top = upper.limbs_[upper.size_ - 1];
+      mp_limb_t mask = top;
+      for (unsigned shift = 1u; shift < GMP_NUMB_BITS; shift *= 2u) {
+        mask |= mask >> shift;
+      }
+      return mask;
+    }();
+    do {
+      for (mp_size_t i = 0; i < upper.size_; ++i) {
+        limbs_[i] = state();
+      }
+      limbs_[upper.size_ - 1] &= top_mask;
+      size_ = upper.size_;
+      normalize_();
+    } while (*this >= upper);
+    return *this;
+  }
+
+  FixedInteger &setToRandom(
+    IsMajsoulFair::IntegerRandomState &state, FixedInteger const &lower, FixedInteger const &upper)
+  {
+    if (lower >= upper) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`lower` must be less than `upper`.");
+    }
+    FixedInteger const range = upper - lower;
+    return setToRandom(state, range) += lower;
+  }
+
+  explicit operator unsigned long() const
+  {
+    if (size_ > 1) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    return size_ == 0 ? 0ul : limbs_[0u];
+  }
+
+  explicit operator long() const
+  {
+    if (*this > static_cast<unsigned long>(LONG_MAX)) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    return static_cast<long>(static_cast<unsigned long>(*this));
+  }
+
+  template<std::size_t B>
+  friend double divideAsDouble(FixedInteger<B> const &numerator, FixedInteger<B> const &denominator);
+
+  template<std::size_t B>
+  friend double log2OfQuotient(FixedInteger<B> const &numerator, FixedInteger<B> const &denominator);
+
+  int compareWithSum(FixedInteger const &lhs, FixedInteger const &rhs) const
+  {
+    return compare_(lhs + rhs);
+  }
+
+  bool operator==(FixedInteger const &rhs) const noexcept
+  {
+    return compare_(rhs) == 0;
+  }
+
+  bool operator==(unsigned long const rhs) const noexcept
+  {
+    return compare_(rhs) == 0;
+  }
+
+  bool operator==(long const rhs) const noexcept
+  {
+    return rhs >= 0 && compare_(static_cast<unsigned long>(rhs)) == 0;
+  }
+
+  bool operator!=(FixedInteger const &rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+  bool operator!=(unsigned long const rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+  bool operator!=(long const rhs) const noexcept
+  {
+    return !(*this == rhs);
+  }
+
+  bool operator<(FixedInteger const &rhs) const noexcept
+  {
+    return compare_(rhs) < 0;
+  }
+
+  bool operator<(unsigned long const rhs) const noexcept
+  {
+    return compare_(rhs) < 0;
+  }
+
+  bool operator<(long const rhs) const noexcept
+  {
+    return rhs >= 0 && compare_(static_cast<unsigned long>(rhs)) < 0;
+  }
+
+  bool operator<=(FixedInteger const &rhs) const noexcept
+  {
+    return compare_(rhs) <= 0;
+  }
+
+  bool operator<=(unsigned long const rhs) const noexcept
+  {
+    return compare_(rhs) <= 0;
+  }
+
+  bool operator<=(long const rhs) const noexcept
+  {
+    return rhs >= 0 && compare_(static_cast<unsigned long>(rhs)) <= 0;
+  }
+
+  bool operator>(FixedInteger const &rhs) const noexcept
+  {
+    return compare_(rhs) > 0;
+  }
+
+  bool operator>(unsigned long const rhs) const noexcept
+  {
+    return compare_(rhs) > 0;
+  }
+
+  bool operator>(long const rhs) const noexcept
+  {
+    return rhs < 0 || compare_(static_cast<unsigned long>(rhs)) > 0;
+  }
+
+  bool operator>=(FixedInteger const &rhs) const noexcept
+  {
+    return compare_(rhs) >= 0;
+  }
+
+  bool operator>=(unsigned long const rhs) const noexcept
+  {
+    return compare_(rhs) >= 0;
+  }
+
+  bool operator>=(long const rhs) const noexcept
+  {
+    return rhs < 0 || compare_(static_cast<unsigned long>(rhs)) >= 0;
+  }
+
+private:
+  void setLimb_(mp_limb_t const value) noexcept
+  {
+    limbs_[0u] = value;
+    size_ = value != 0u ? 1 : 0;
+  }
+
+  void normalize_() noexcept
+  {
+    while (size_ > 0 && limbs_[size_ - 1] == 0u) {
+      --size_;
+    }
+  }
+
+  // Writes the product of two nonzero values into `product`, and returns the
+  // number of its limbs.
+  static mp_size_t multiply_(
+    FixedInteger const &lhs, FixedInteger const &rhs, std::array<mp_limb_t, 2u * num_limbs_> &product) noexcept
+  {
+    if (lhs.size_ >= rhs.size_) {
+      mpn_mul(product.data(), lhs.limbs_.data(), lhs.size_, rhs.limbs_.data(), rhs.size_);
+    }
+    else {
+      mpn_mul(product.data(), rhs.limbs_.data(), rhs.size_, lhs.limbs_.data(), lhs.size_);
+    }
+    mp_size_t const product_size = lhs.size_ + rhs.size_;
+    return product[product_size - 1] == 0u ? product_size - 1 : product_size;
+  }
+
+  void pushCarry_(mp_limb_t const carry)
+  {
+    if (carry == 0u) {
+      return;
+    }
+    if (size_ == num_limbs_) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    limbs_[size_++] = carry;
+  }
+
+  unsigned char getByte_(std::size_t const position) const noexcept
+  {
+    std::size_t const limb_index = position / GMP_NUMB_BITS;
+    unsigned const bit_index = position % GMP_NUMB_BITS;
+    if (limb_index >= static_cast<std::size_t>(size_)) {
+      return 0u;
+    }
+    mp_limb_t word = limbs_[limb_index] >> bit_index;
+    if (bit_index > GMP_NUMB_BITS - 8u && limb_index + 1u < static_cast<std::size_t>(size_)) {
+      word |= limbs_[limb_index + 1u] << (GMP_NUMB_BITS - bit_index);
+    }
+    return static_cast<unsigned char>(word);
+  }
+
+  void orByte_(std::size_t const position, unsigned char const byte)
+  {
+    if (byte == 0u) {
+      return;
+    }
+    std::size_t const limb_index = position / GMP_NUMB_BITS;
+    unsigned const bit_index = position % GMP_NUMB_BITS;
+    mp_limb_t const high = bit_index > GMP_NUMB_BITS - 8u ? mp_limb_t(byte) >> (GMP_NUMB_BITS - bit_index) : 0u;
+    if (limb_index >= static_cast<std::size_t>(num_limbs_)
+        || (high != 0u && limb_index + 1u >= static_cast<std::size_t>(num_limbs_))) {
+      IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
+    }
+    limbs_[limb_index] |= mp_limb_t(byte) << bit_index;
+    if (high != 0u) {
+      limbs_[limb_index + 1u] |= high;
+    }
+  }
+
+  int compare_(FixedInteger const &rhs) const noexcept
+  {
+    if (size_ != rhs.size_) {
+      return size_ < rhs.size_ ? -1 : 1;
+    }
+    if (size_ == 0) {
+      return 0;
+    }
+    return mpn_cmp(limbs_.data(), rhs.limbs_.data(), size_);
+  }
+
+  int compare_(unsigned long const rhs) const noexcept
+  {
+    if (size_ > 1) {
+      return 1;
+    }
+    mp_limb_t const value = size_ == 0 ? 0u : limbs_[0u];
+    return value < rhs ? -1 : (value > rhs ? 1 : 0);
+  }
+
+  void divide_(FixedInteger const &divisor, FixedInteger &quotient, FixedInteger &remainder) const
+  {
+    if (divisor.size_ == 0) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
+    }
+    if (size_ < divisor.size_) {
+      remainder = *this;
+      quotient.size_ = 0;
+      return;
+    }
+    std::array<mp_limb_t, num_limbs_> q;
+    std::array<mp_limb_t, num_limbs_> r;
+    mpn_tdiv_qr(
+      q.data(), r.data(), 0, limbs_.data(), size_, divisor.limbs_.data(), divisor.size_);
+    mp_size_t const quotient_size = size_ - divisor.size_ + 1;
+    quotient.size_ = quotient_size;
+    std::copy_n(q.data(), quotient_size, quotient.limbs_.data());
+    quotient.normalize_();
+    remainder.size_ = divisor.size_;
+    std::copy_n(r.data(), divisor.size_, remainder.limbs_.data());
+    remainder.normalize_();
+  }
+
+  // Returns the value truncated to the 53 most significant bits, scaled to
+  // [0.5, 1), together with its binary exponent, in the same way as
+  // `mpz_get_d_2exp`.
+  double getDouble2Exp_(long &exp) const noexcept
+  {
+    if (size_ == 0) {
+      exp = 0;
+      return 0.0;
+    }
+    mp_limb_t const top = limbs_[size_ - 1];
+    int const leading_zeros = __builtin_clzl(top);
+    mp_limb_t head = top << leading_zeros;
+    if (leading_zeros != 0 && size_ >= 2) {
+      head |= limbs_[size_ - 2] >> (GMP_NUMB_BITS - leading_zeros);
+    }
+    exp = static_cast<long>(size_) * GMP_NUMB_BITS - leading_zeros;
+    return std::ldexp(static_cast<double>(head >> (GMP_NUMB_BITS - 53)), -53);
+  }
+
+  std::array<mp_limb_t, num_limbs_> limbs_;
+  mp_size_t size_;
+}; // class FixedInteger
+
+template<std::size_t Bits>
+double divideAsDouble(FixedInteger<Bits> const &numerator, FixedInteger<Bits> const &denominator)
+{
+  if (denominator == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`denominator` must not be zero.");
+  }
+  long exp = 0;
+  double const mantissa = numerator.getDouble2Exp_(exp);
+  long denominator_exp = 0;
+  double const denominator_mantissa = denominator.getDouble2Exp_(denominator_exp);
+  exp -= denominator_exp;
+  return (mantissa / denominator_mantissa) * std::pow(2.0, exp);
+}
+
+template<std::size_t Bits>
+double log2OfQuotient(FixedInteger<Bits> const &numerator, FixedInteger<Bits> const &denominator)
+{
+  if (numerator == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`numerator` must not be zero.");
+  }
+  if (denominator == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`denominator` must not be zero.");
+  }
+  long exp = 0;
+  double const mantissa = numerator.getDouble2Exp_(exp);
+  long denominator_exp = 0;
+  double const denominator_mantissa = denominator.getDouble2Exp_(denominator_exp);
+  return std::log2(mantissa / denominator_mantissa) + static_cast<double>(exp - denominator_exp);
+}
+
+template<std::size_t Bits>
+void swap(FixedInteger<Bits> &lhs, FixedInteger<Bits> &rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+template<std::size_t Bits>
+void swap(FixedInteger<Bits> &lhs, FixedInteger<Bits> &&rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+template<std::size_t Bits>
+void swap(FixedInteger<Bits> &&lhs, FixedInteger<Bits> &rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+template<std::size_t Bits>
+FixedInteger<Bits> operator+(unsigned long const lhs, FixedInteger<Bits> const &rhs)
+{
+  return rhs + lhs;
+}
+
+template<std::size_t Bits>
+FixedInteger<Bits> operator-(unsigned long const lhs, FixedInteger<Bits> const &rhs)
+{
+  return FixedInteger<Bits>(lhs) - rhs;
+}
+
+template<std::size_t Bits>
+FixedInteger<Bits> operator*(unsigned long const lhs, FixedInteger<Bits> const &rhs)
+{
+  return rhs * lhs;
+}
+
+template<std::size_t Bits>
+FixedInteger<Bits> operator*(long const lhs, FixedInteger<Bits> const &rhs)
+{
+  return rhs * lhs;
+}
+
+template<std::size_t Bits>
+FixedInteger<Bits> operator/(unsigned long const lhs, FixedInteger<Bits> const &rhs)
+{
+  return FixedInteger<Bits>(lhs) / rhs;
+}
+
+template<std::size_t Bits>
+FixedInteger<Bits> operator%(unsigned long const lhs, FixedInteger<Bits> const &rhs)
+{
+  return FixedInteger<Bits>(lhs) % rhs;
+}
+
+template<std::size_t Bits>
+bool operator==(unsigned long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs == lhs;
+}
+
+template<std::size_t Bits>
+bool operator==(long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs == lhs;
+}
+
+template<std::size_t Bits>
+bool operator!=(unsigned long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs != lhs;
+}
+
+template<std::size_t Bits>
+bool operator!=(long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs != lhs;
+}
+
+template<std::size_t Bits>
+bool operator<(unsigned long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs > lhs;
+}
+
+template<std::size_t Bits>
+bool operator<(long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs > lhs;
+}
+
+template<std::size_t Bits>
+bool operator<=(unsigned long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs >= lhs;
+}
+
+template<std::size_t Bits>
+bool operator<=(long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs >= lhs;
+}
+
+template<std::size_t Bits>
+bool operator>(unsigned long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs < lhs;
+}
+
+template<std::size_t Bits>
+bool operator>(long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs < lhs;
+}
+
+template<std::size_t Bits>
+bool operator>=(unsigned long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs <= lhs;
+}
+
+template<std::size_t Bits>
+bool operator>=(long const lhs, FixedInteger<Bits> const &rhs) noexcept
+{
+  return rhs <= lhs;
+}
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_FIXED_INTEGER_HPP)
@@ -0,0 +1,191 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "gmp_arena.hpp"
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <new>
+#include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <gmp.h>
+
+
+namespace IsMajsoulFair{
+
+namespace{
+
+constexpr std::size_t alignment = alignof(std::max_align_t);
+
+constexpr std::size_t min_block_size = 64u * 1024u;
+
+std::size_t roundUp(std::size_t const size) noexcept
+{
+  return (size + alignment - 1u) / alignment * alignment;
+}
+
+class Arena
+{
+public:
+  bool isActive() const noexcept
+  {
+    return depth_ != 0u;
+  }
+
+  void enter(std::size_t &block_index, std::size_t &offset) noexcept
+  {
+    block_index = block_index_;
+    offset = offset_;
+    ++depth_;
+  }
+
+  void leave(std::size_t const block_index, std::size_t const offset) noexcept
+  {
+    block_index_ = block_index;
+    offset_ = offset;
+    --depth_;
+  }
+
+  bool owns(void const * const p) const noexcept
+  {
+    std::byte const * const q = static_cast<std::byte const *>(p);
+    std::less<std::byte const *> const less;
+    for (Block_ const &block : blocks_) {
+      if (!less(q, block.data.get()) && less(q, block.data.get() + block.size)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void *allocate(std::size_t size)
+  {
+    size = roundUp(size);
+    if (!blocks_.empty() && blocks_[block_index_].size - offset_ >= size) {
+      void * const p = blocks_[block_index_].data.get() + offset_;
+      offset_ += size;
+      return p;
+    }
+    for (std::size_t i = blocks_.empty() ? 0u : block_index_ + 1u; i < blocks_.size(); ++i) {
+      if (blocks_[i].size >= size) {
+        block_index_ = i;
+        offset_ = size;
+        return blocks_[i].data.get();
+      }
+    }
+
+    std::size_t const block_size = std::max({
+      min_block_size, blocks_.empty() ? 0u : 2u * blocks_.back().size, size});
+    std::unique_ptr<std::byte[]> data(new(std::nothrow) std::byte[block_size]);
+    if (data == nullptr) {
+      std::abort();
+    }
+    blocks_.push_back(Block_{std::move(data), block_size});
+    block_index_ = blocks_.size() - 1u;
+    offset_ = size;
+    return blocks_.back().data.get();
+  }
+
+  void *reallocate(void * const p, std::size_t const old_size, std::size_t const new_size)
+  {
+    if (isTop_(p, old_size)) {
+      std::size_t const base = offset_ - roundUp(old_size);
+      if (blocks_[block_index_].size - base >= roundUp(new_size)) {
+        offset_ = base + roundUp(new_size);
+        return p;
+      }
+    }
+    void * const q = allocate(new_size);
+    std::memcpy(q, p, std::min(old_size, new_size));
+    return q;
+  }
+
+  void deallocate(void * const p, std::size_t const size) noexcept
+  {
+    if (isTop_(p, size)) {
+      offset_ -= roundUp(size);
+    }
+  }
+
+private:
+  struct Block_
+  {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t size;
+  }; // struct Block_
+
+  bool isTop_(void const * const p, std::size_t const size) const noexcept
+  {
+    return !blocks_.empty() && roundUp(size) <= offset_
+      && p == blocks_[block_index_].data.get() + offset_ - roundUp(size);
+  }
+
+  std::vector<Block_> blocks_;
+  std::size_t block_index_ = 0u;
+  std::size_t offset_ = 0u;
+  std::size_t depth_ = 0u;
+}; // class Arena
+
+thread_local Arena arena;
+
+void *allocateFunction(std::size_t const size)
+{
+  if (arena.isActive()) {
+    return arena.allocate(size);
+  }
+  void * const p = std::malloc(size);
+  if (p == nullptr) {
+    std::abort();
+  }
+  return p;
+}
+
+void *reallocateFunction(void * const p, std::size_t const old_size, std::size_t const new_size)
+{
+  if (arena.isActive() && arena.owns(p)) {
+    return arena.reallocate(p, old_size, new_size);
+  }
+  void * const q = std::realloc(p, new_size);
+  if (q == nullptr) {
+    std::abort();
+  }
+  return q;
+}
+
+void freeFunction(void * const p, std::size_t const size)
+{
+  if (arena.isActive() && arena.owns(p)) {
+    arena.deallocate(p, size);
+    return;
+  }
+  std::free(p);
+}
+
+} // namespace <unnamed>
+
+void installGmpArena()
+{
+  static std::once_flag flag;
+  std::call_once(flag, []() {
+    mp_set_memory_functions(&allocateFunction, &reallocateFunction, &freeFunction);
+  });
+}
+
+GmpArenaFrame::GmpArenaFrame()
+  : block_index_(),
+    offset_()
+{
+  arena.enter(block_index_, offset_);
+}
+
+GmpArenaFrame::~GmpArenaFrame()
+{
+  arena.leave(block_index_, offset_);
+}
+
+} // namespace IsMajsoulFair
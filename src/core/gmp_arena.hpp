@@ -0,0 +1,40 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_GMP_ARENA_HPP)
+#define CORE_GMP_ARENA_HPP
+
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// Replaces GMP's memory functions with ones that serve allocations from a
+// thread-local bump arena while a `GmpArenaFrame` is alive on the calling
+// thread, and from the heap otherwise. Idempotent and thread-safe.
+void installGmpArena();
+
+// Every GMP allocation made on this thread during the lifetime of a frame is
+// released at once when the frame is destroyed. Hence an `Integer` that
+// outlives a frame must be neither created nor modified inside it, since GMP
+// may move its limbs into the arena. Frames nest.
+class GmpArenaFrame
+{
+public:
+  GmpArenaFrame();
+
+  GmpArenaFrame(GmpArenaFrame const &) = delete;
+
+  GmpArenaFrame &operator=(GmpArenaFrame const &) = delete;
+
+  ~GmpArenaFrame();
+
+private:
+  std::size_t block_index_;
+  std::size_t offset_;
+}; // class GmpArenaFrame
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_GMP_ARENA_HPP)
@@ -4,207 +4,96 @@
 
 #include "integer.hpp"
 
+#include "uniform_integer_sampler.hpp"
 #include "../common/throw.hpp"
+#include <utility>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <stdexcept>
 #include <gmp.h>
+#include <climits>
 #include <cmath>
 
 
 namespace IsMajsoulFair{
 
-class Integer::Impl_
-{
-public:
-  Impl_()
-  {
-    mpz_init(value_);
-  }
-
-  explicit Impl_(unsigned long const value)
-  {
-    mpz_init_set_ui(value_, value);
-  }
+namespace{
 
-  explicit Impl_(long const value)
-  {
-    mpz_init_set_si(value_, value);
-  }
+static_assert(GMP_NUMB_BITS == 64);
 
-  Impl_(Impl_ const &other)
-  {
-    mpz_init_set(value_, other.value_);
-  }
+using SmallInteger = __int128;
 
-  Impl_(Impl_ &&) = delete;
+constexpr SmallInteger small_integer_min = static_cast<SmallInteger>(static_cast<unsigned __int128>(1u) << 127u);
 
-  ~Impl_()
-  {
-    mpz_clear(value_);
-  }
-
-  Impl_ &operator=(Impl_ const &) = delete;
-
-  Impl_ &operator=(Impl_ &&) = delete;
-
-  void operator+=(Impl_ const &rhs)
-  {
-    mpz_add(value_, value_, rhs.value_);
-  }
-
-  void operator+=(unsigned long const rhs)
-  {
-    mpz_add_ui(value_, value_, rhs);
-  }
+// The largest sum `Integer::compareWithSum` forms on the stack.
+constexpr mp_size_t max_stack_limbs = 64;
 
-  void operator-=(Impl_ const &rhs)
-  {
-    mpz_sub(value_, value_, rhs.value_);
-  }
-
-  void operator-=(unsigned long const rhs)
-  {
-    mpz_sub_ui(value_, value_, rhs);
-  }
-
-  void operator*=(Impl_ const &rhs)
-  {
-    mpz_mul(value_, value_, rhs.value_);
-  }
-
-  void operator*=(unsigned long const rhs)
-  {
-    mpz_mul_ui(value_, value_, rhs);
-  }
-
-  void operator*=(long const rhs)
-  {
-    mpz_mul_si(value_, value_, rhs);
-  }
-
-  void operator/=(Impl_ const &rhs)
-  {
-    mpz_tdiv_q(value_, value_, rhs.value_);
-  }
-
-  void operator/=(unsigned long const rhs)
-  {
-    mpz_tdiv_q_ui(value_, value_, rhs);
-  }
-
-  void operator%=(Impl_ const &rhs)
-  {
-    mpz_tdiv_r(value_, value_, rhs.value_);
-  }
-
-  void operator%=(unsigned long const rhs)
-  {
-    mpz_tdiv_r_ui(value_, value_, rhs);
-  }
-
-  void inplacePow(unsigned long const exponent)
-  {
-    mpz_pow_ui(value_, value_, exponent);
-  }
-
-  void setToRandom(gmp_randstate_t state, Impl_ const &upper)
-  {
-    mpz_urandomm(value_, state, upper.value_);
-  }
-
-  explicit operator unsigned long() const
-  {
-    return mpz_get_ui(value_);
-  }
-
-  explicit operator long() const
-  {
-    return mpz_get_si(value_);
-  }
-
-  double divideAsDouble(Impl_ const &denominator) const
-  {
-    long int exp = 0;
-    double const mantissa = mpz_get_d_2exp(&exp, value_);
-  
-    long int denominator_exp = 0;
-    double const denominator_mantissa = mpz_get_d_2exp(&denominator_exp, denominator.value_);
-  
-    exp -= denominator_exp;
-    return (mantissa / denominator_mantissa) * std::pow(2.0, exp);
-  }
-
-  bool operator==(Impl_ const &rhs) const
-  {
-    return mpz_cmp(value_, rhs.value_) == 0;
-  }
-
-  bool operator==(unsigned long const rhs) const
-  {
-    return mpz_cmp_ui(value_, rhs) == 0;
-  }
-
-  bool operator==(long const rhs) const
-  {
-    return mpz_cmp_si(value_, rhs) == 0;
-  }
-
-  bool operator<(Impl_ const &rhs) const
-  {
-    return mpz_cmp(value_, rhs.value_) < 0;
-  }
-
-  bool operator<(unsigned long const rhs) const
-  {
-    return mpz_cmp_ui(value_, rhs) < 0;
-  }
-
-  bool operator<(long const rhs) const
-  {
-    return mpz_cmp_si(value_, rhs) < 0;
-  }
-
-  bool operator<=(unsigned long const rhs) const
-  {
-    return mpz_cmp_ui(value_, rhs) <= 0;
-  }
+int sign(int const value) noexcept
+{
+  return (value > 0) - (value < 0);
+}
 
-  bool operator<=(long const rhs) const
-  {
-    return mpz_cmp_si(value_, rhs) <= 0;
-  }
+} // namespace <unnamed>
 
-  bool operator>(unsigned long const rhs) const
+// Presents either representation of an `Integer` as a read-only `mpz_t`
+// without allocating.
+class Integer::View_
+{
+public:
+  explicit View_(Integer const &integer) noexcept
   {
-    return mpz_cmp_ui(value_, rhs) > 0;
+    if (!integer.is_small_) {
+      p_ = integer.storage_.big;
+      return;
+    }
+    SmallInteger const value = integer.storage_.small;
+    unsigned __int128 const magnitude
+      = value < 0 ? -static_cast<unsigned __int128>(value) : static_cast<unsigned __int128>(value);
+    limbs_[0u] = static_cast<mp_limb_t>(magnitude);
+    limbs_[1u] = static_cast<mp_limb_t>(magnitude >> 64u);
+    mp_size_t const size = limbs_[1u] != 0u ? 2 : (limbs_[0u] != 0u ? 1 : 0);
+    p_ = mpz_roinit_n(view_, limbs_, value < 0 ? -size : size);
   }
 
-  bool operator>(long const rhs) const
-  {
-    return mpz_cmp_si(value_, rhs) > 0;
-  }
+  View_(View_ const &) = delete;
 
-  bool operator>=(unsigned long const rhs) const
-  {
-    return mpz_cmp_ui(value_, rhs) >= 0;
-  }
+  View_ &operator=(View_ const &) = delete;
 
-  bool operator>=(long const rhs) const
+  mpz_srcptr get() const noexcept
   {
-    return mpz_cmp_si(value_, rhs) >= 0;
+    return p_;
   }
 
 private:
-  mpz_t value_;
-}; // class Integer::Impl_
+  mp_limb_t limbs_[2u];
+  mpz_t view_;
+  mpz_srcptr p_;
+}; // class Integer::View_
 
 class IntegerRandomState::Impl_
 {
 public:
   Impl_()
+    : is_counter_based_(false),
+      key_(),
+      stream_(),
+      position_(),
+      block_(),
+      is_block_valid_()
   {
     gmp_randinit_mt(state_);
   }
 
+  Impl_(std::array<std::uint64_t, 2u> const &seed, std::uint64_t const stream)
+    : is_counter_based_(true),
+      key_(seed),
+      stream_(stream),
+      position_(0u),
+      block_(),
+      is_block_valid_(false)
+  {}
+
   Impl_(Impl_ const &other) = delete;
 
   Impl_(Impl_ &&other) = delete;
@@ -215,7 +104,14 @@ public:
 
   ~Impl_()
   {
-    gmp_randclear(state_);
+    if (!is_counter_based_) {
+      gmp_randclear(state_);
+    }
+  }
+
+  bool isCounterBased() const noexcept
+  {
+    return is_counter_based_;
   }
 
   gmp_randstate_t &get() noexcept
@@ -223,45 +119,145 @@ public:
     return state_;
   }
 
+  std::uint64_t next()
+  {
+    if (!is_counter_based_) {
+      return gmp_urandomb_ui(state_, 64u);
+    }
+    if (!is_block_valid_ || position_ % 4u == 0u) {
+      generate_(position_ / 4u);
+    }
+    return block_[position_++ % 4u];
+  }
+
+  void generate(std::uint64_t *first, std::uint64_t * const last)
+  {
+    if (!is_counter_based_) {
+      for (; first != last; ++first) {
+        *first = next();
+      }
+      return;
+    }
+    for (; first != last && position_ % 4u != 0u; ++first) {
+      *first = next();
+    }
+    for (; last - first >= 4; first += 4) {
+      generate_(position_ / 4u);
+      std::copy(block_.cbegin(), block_.cend(), first);
+      position_ += 4u;
+    }
+    for (; first != last; ++first) {
+      *first = next();
+    }
+  }
+
+  void jump(unsigned long long const n)
+  {
+    if (!is_counter_based_) {
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A Mersenne Twister state cannot jump.");
+    }
+    position_ += n;
+    is_block_valid_ = false;
+  }
+
 private:
+  // Philox4x64-10 of Salmon et al., "Parallel random numbers: As easy as
+  // 1, 2, 3", SC '11. The counter is the block index followed by the stream.
+  void generate_(unsigned __int128 const index) noexcept
+  {
+    std::array<std::uint64_t, 4u> counter{
+      static_cast<std::uint64_t>(index), static_cast<std::uint64_t>(index >> 64u), stream_, 0u};
+    std::array<std::uint64_t, 2u> key = key_;
+    for (int round = 0; round < 10; ++round) {
+      unsigned __int128 const product0 = static_cast<unsigned __int128>(0xD2E7470EE14C6C93u) * counter[0u];
+      unsigned __int128 const product1 = static_cast<unsigned __int128>(0xCA5A826395121157u) * counter[2u];
+      counter = {
+        static_cast<std::uint64_t>(product1 >> 64u) ^ counter[1u] ^ key[0u],
+        static_cast<std::uint64_t>(product1),
+        static_cast<std::uint64_t>(product0 >> 64u) ^ counter[3u] ^ key[1u],
+        static_cast<std::uint64_t>(product0)};
+      key[0u] += 0x9E3779B97F4A7C15u;
+      key[1u] += 0xBB67AE8584CAA73Bu;
+    }
+    block_ = counter;
+    is_block_valid_ = true;
+  }
+
+  bool is_counter_based_;
   gmp_randstate_t state_;
+  std::array<std::uint64_t, 2u> key_;
+  std::uint64_t stream_;
+  unsigned __int128 position_;
+  std::array<std::uint64_t, 4u> block_;
+  bool is_block_valid_;
 }; // class IntegerRandomState::Impl_
 
 Integer::Integer()
-  : p_impl_(std::make_shared<Impl_>())
-{}
+  : is_small_(true)
+{
+  storage_.small = 0;
+}
 
 Integer::Integer(unsigned long const value)
-  : p_impl_(std::make_shared<Impl_>(value))
-{}
+  : is_small_(true)
+{
+  storage_.small = value;
+}
 
 Integer::Integer(long const value)
-  : p_impl_(std::make_shared<Impl_>(value))
-{}
+  : is_small_(true)
+{
+  storage_.small = value;
+}
 
 Integer::Integer(Integer const &other)
-  : p_impl_(std::make_shared<Impl_>(*other.p_impl_))
-{}
+  : is_small_(other.is_small_)
+{
+  if (is_small_) {
+    storage_.small = other.storage_.small;
+  }
+  else {
+    mpz_init_set(storage_.big, other.storage_.big);
+  }
+}
 
 Integer::Integer(Integer &&other) noexcept
-  : p_impl_(std::move(other.p_impl_))
+  : is_small_(other.is_small_),
+    storage_(other.storage_)
 {
-  other.p_impl_ = nullptr;
+  other.is_small_ = true;
+  other.storage_.small = 0;
+}
+
+Integer::~Integer()
+{
+  if (!is_small_) {
+    mpz_clear(storage_.big);
+  }
 }
 
 void Integer::swap(Integer &other) noexcept
 {
-  p_impl_.swap(other.p_impl_);
+  std::swap(is_small_, other.is_small_);
+  std::swap(storage_, other.storage_);
 }
 
 void Integer::swap(Integer &&other) noexcept
 {
-  p_impl_.swap(other.p_impl_);
+  swap(other);
 }
 
 Integer &Integer::operator=(Integer const &other)
 {
-  Integer(other).swap(*this);
+  if (this == &other) {
+    return *this;
+  }
+  if (is_small_ && other.is_small_) {
+    storage_.small = other.storage_.small;
+    return *this;
+  }
+  promote_();
+  mpz_set(storage_.big, View_(other).get());
   return *this;
 }
 
@@ -273,21 +269,28 @@ Integer &Integer::operator=(Integer &&other) noexcept
 
 Integer &Integer::operator=(unsigned long const value)
 {
-  Integer(value).swap(*this);
+  if (is_small_) {
+    storage_.small = value;
+  }
+  else {
+    mpz_set_ui(storage_.big, value);
+  }
   return *this;
 }
 
 Integer &Integer::operator=(long const value)
 {
-  Integer(value).swap(*this);
+  if (is_small_) {
+    storage_.small = value;
+  }
+  else {
+    mpz_set_si(storage_.big, value);
+  }
   return *this;
 }
 
 Integer &Integer::operator++()
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }
   return *this += 1ul;
 }
 
@@ -300,9 +303,6 @@ Integer Integer::operator++(int)
 
 Integer &Integer::operator--()
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }
   return *this -= 1ul;
 }
 
@@ -315,202 +315,519 @@ Integer Integer::operator--(int)
 
 Integer &Integer::operator+=(Integer const &rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_ && rhs.is_small_) {
+    SmallInteger result;
+    if (!__builtin_add_overflow(storage_.small, rhs.storage_.small, &result)) {
+      storage_.small = result;
+      return *this;
+    }
   }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
-  }
-  *p_impl_ += *rhs.p_impl_;
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_add(storage_.big, storage_.big, rhs_view.get());
   return *this;
 }
 
 Integer &Integer::operator+=(unsigned long const rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    SmallInteger result;
+    if (!__builtin_add_overflow(storage_.small, static_cast<SmallInteger>(rhs), &result)) {
+      storage_.small = result;
+      return *this;
+    }
+    promote_();
   }
-  *p_impl_ += rhs;
+  mpz_add_ui(storage_.big, storage_.big, rhs);
   return *this;
 }
 
 Integer Integer::operator+(Integer const &rhs) const
 {
-  return Integer(*this) += rhs;
+  Integer result(*this);
+  result += rhs;
+  return result;
 }
 
 Integer Integer::operator+(unsigned long const rhs) const
 {
-  return Integer(*this) += rhs;
+  Integer result(*this);
+  result += rhs;
+  return result;
 }
 
 Integer &Integer::operator-=(Integer const &rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_ && rhs.is_small_) {
+    SmallInteger result;
+    if (!__builtin_sub_overflow(storage_.small, rhs.storage_.small, &result)) {
+      storage_.small = result;
+      return *this;
+    }
   }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
-  }
-  *p_impl_ -= *rhs.p_impl_;
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_sub(storage_.big, storage_.big, rhs_view.get());
   return *this;
 }
 
 Integer &Integer::operator-=(unsigned long const rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    SmallInteger result;
+    if (!__builtin_sub_overflow(storage_.small, static_cast<SmallInteger>(rhs), &result)) {
+      storage_.small = result;
+      return *this;
+    }
+    promote_();
   }
-  *p_impl_ -= rhs;
+  mpz_sub_ui(storage_.big, storage_.big, rhs);
   return *this;
 }
 
 Integer Integer::operator-(Integer const &rhs) const
 {
-  return Integer(*this) -= rhs;
+  Integer result(*this);
+  result -= rhs;
+  return result;
 }
 
 Integer Integer::operator-(unsigned long const rhs) const
 {
-  return Integer(*this) -= rhs;
+  Integer result(*this);
+  result -= rhs;
+  return result;
 }
 
 Integer &Integer::operator*=(Integer const &rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
+  if (is_small_ && rhs.is_small_) {
+    SmallInteger result;
+    if (!__builtin_mul_overflow(storage_.small, rhs.storage_.small, &result)) {
+      storage_.small = result;
+      return *this;
+    }
   }
-  *p_impl_ *= *rhs.p_impl_;
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_mul(storage_.big, storage_.big, rhs_view.get());
   return *this;
 }
 
 Integer &Integer::operator*=(unsigned long const rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    SmallInteger result;
+    if (!__builtin_mul_overflow(storage_.small, static_cast<SmallInteger>(rhs), &result)) {
+      storage_.small = result;
+      return *this;
+    }
+    promote_();
   }
-  *p_impl_ *= rhs;
+  mpz_mul_ui(storage_.big, storage_.big, rhs);
   return *this;
 }
 
 Integer &Integer::operator*=(long const rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    SmallInteger result;
+    if (!__builtin_mul_overflow(storage_.small, static_cast<SmallInteger>(rhs), &result)) {
+      storage_.small = result;
+      return *this;
+    }
+    promote_();
   }
-  *p_impl_ *= rhs;
+  mpz_mul_si(storage_.big, storage_.big, rhs);
   return *this;
 }
 
 Integer Integer::operator*(Integer const &rhs) const
 {
-  return Integer(*this) *= rhs;
+  Integer result(*this);
+  result *= rhs;
+  return result;
 }
 
 Integer Integer::operator*(unsigned long const rhs) const
 {
-  return Integer(*this) *= rhs;
+  Integer result(*this);
+  result *= rhs;
+  return result;
 }
 
 Integer Integer::operator*(long const rhs) const
 {
-  return Integer(*this) *= rhs;
+  Integer result(*this);
+  result *= rhs;
+  return result;
 }
 
 Integer &Integer::operator/=(Integer const &rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (rhs == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
   }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
+  if (is_small_ && rhs.is_small_) {
+    if (storage_.small != small_integer_min || rhs.storage_.small != -1) {
+      storage_.small /= rhs.storage_.small;
+      return *this;
+    }
   }
-  *p_impl_ /= *rhs.p_impl_;
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_tdiv_q(storage_.big, storage_.big, rhs_view.get());
   return *this;
 }
 
 Integer &Integer::operator/=(unsigned long const rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (rhs == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
   }
-  *p_impl_ /= rhs;
+  if (is_small_) {
+    storage_.small /= static_cast<SmallInteger>(rhs);
+    return *this;
+  }
+  mpz_tdiv_q_ui(storage_.big, storage_.big, rhs);
   return *this;
 }
 
 Integer Integer::operator/(Integer const &rhs) const
 {
-  return Integer(*this) /= rhs;
+  Integer result(*this);
+  result /= rhs;
+  return result;
 }
 
 Integer Integer::operator/(unsigned long const rhs) const
 {
-  return Integer(*this) /= rhs;
+  Integer result(*this);
+  result /= rhs;
+  return result;
 }
 
 Integer &Integer::operator%=(Integer const &rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (rhs == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
   }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
+  if (is_small_ && rhs.is_small_) {
+    storage_.small = rhs.storage_.small == -1 ? 0 : storage_.small % rhs.storage_.small;
+    return *this;
   }
-  *p_impl_ %= *rhs.p_impl_;
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_tdiv_r(storage_.big, storage_.big, rhs_view.get());
   return *this;
 }
 
 Integer &Integer::operator%=(unsigned long const rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (rhs == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("Division by zero.");
   }
-  *p_impl_ %= rhs;
+  if (is_small_) {
+    storage_.small %= static_cast<SmallInteger>(rhs);
+    return *this;
+  }
+  mpz_tdiv_r_ui(storage_.big, storage_.big, rhs);
   return *this;
 }
 
 Integer Integer::operator%(Integer const &rhs) const
 {
-  return Integer(*this) %= rhs;
+  Integer result(*this);
+  result %= rhs;
+  return result;
 }
 
 Integer Integer::operator%(unsigned long const rhs) const
 {
-  return Integer(*this) %= rhs;
+  Integer result(*this);
+  result %= rhs;
+  return result;
 }
 
-Integer &Integer::inplacePow(unsigned long const exponent)
+Integer &Integer::addmul(Integer const &lhs, Integer const &rhs)
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_ && lhs.is_small_ && rhs.is_small_) {
+    SmallInteger product;
+    SmallInteger result;
+    if (!__builtin_mul_overflow(lhs.storage_.small, rhs.storage_.small, &product)
+        && !__builtin_add_overflow(storage_.small, product, &result)) {
+      storage_.small = result;
+      return *this;
+    }
+  }
+  View_ const lhs_view(lhs);
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_addmul(storage_.big, lhs_view.get(), rhs_view.get());
+  return *this;
+}
+
+Integer &Integer::addmul(Integer const &lhs, unsigned long const rhs)
+{
+  if (is_small_ && lhs.is_small_) {
+    SmallInteger product;
+    SmallInteger result;
+    if (!__builtin_mul_overflow(lhs.storage_.small, static_cast<SmallInteger>(rhs), &product)
+        && !__builtin_add_overflow(storage_.small, product, &result)) {
+      storage_.small = result;
+      return *this;
+    }
   }
-  p_impl_->inplacePow(exponent);
+  View_ const lhs_view(lhs);
+  promote_();
+  mpz_addmul_ui(storage_.big, lhs_view.get(), rhs);
+  return *this;
+}
+
+Integer &Integer::submul(Integer const &lhs, Integer const &rhs)
+{
+  if (is_small_ && lhs.is_small_ && rhs.is_small_) {
+    SmallInteger product;
+    SmallInteger result;
+    if (!__builtin_mul_overflow(lhs.storage_.small, rhs.storage_.small, &product)
+        && !__builtin_sub_overflow(storage_.small, product, &result)) {
+      storage_.small = result;
+      return *this;
+    }
+  }
+  View_ const lhs_view(lhs);
+  View_ const rhs_view(rhs);
+  promote_();
+  mpz_submul(storage_.big, lhs_view.get(), rhs_view.get());
+  return *this;
+}
+
+Integer &Integer::submul(Integer const &lhs, unsigned long const rhs)
+{
+  if (is_small_ && lhs.is_small_) {
+    SmallInteger product;
+    SmallInteger result;
+    if (!__builtin_mul_overflow(lhs.storage_.small, static_cast<SmallInteger>(rhs), &product)
+        && !__builtin_sub_overflow(storage_.small, product, &result)) {
+      storage_.small = result;
+      return *this;
+    }
+  }
+  View_ const lhs_view(lhs);
+  promote_();
+  mpz_submul_ui(storage_.big, lhs_view.get(), rhs);
+  return *this;
+}
+
+void Integer::reserve(std::size_t const bits)
+{
+  if (is_small_ && bits < sizeof(SmallInteger) * CHAR_BIT) {
+    return;
+  }
+  mp_size_t const num_limbs = (bits + GMP_NUMB_BITS - 1u) / GMP_NUMB_BITS;
+  if (is_small_) {
+    View_ const view(*this);
+    mpz_init2(storage_.big, bits);
+    mpz_set(storage_.big, view.get());
+    is_small_ = false;
+    return;
+  }
+  if (storage_.big->_mp_alloc < num_limbs) {
+    _mpz_realloc(storage_.big, num_limbs);
+  }
+}
+
+Integer &Integer::inplacePow(unsigned long const exponent)
+{
+  if (is_small_) {
+    SmallInteger base = storage_.small;
+    SmallInteger result = 1;
+    bool overflow = false;
+    for (unsigned long e = exponent; e != 0u && !overflow;) {
+      if ((e & 1u) != 0u) {
+        overflow = __builtin_mul_overflow(result, base, &result);
+      }
+      e >>= 1u;
+      if (e != 0u && !overflow) {
+        overflow = __builtin_mul_overflow(base, base, &base);
+      }
+    }
+    if (!overflow) {
+      storage_.small = result;
+      return *this;
+    }
+    promote_();
+  }
+  mpz_pow_ui(storage_.big, storage_.big, exponent);
   return *this;
 }
 
 Integer Integer::pow(unsigned long const exponent) const
 {
-  return Integer(*this).inplacePow(exponent);
+  Integer result(*this);
+  result.inplacePow(exponent);
+  return result;
+}
+
+Integer &Integer::operator<<=(std::size_t const shift)
+{
+  if (is_small_) {
+    SmallInteger const value = storage_.small;
+    if (value == 0) {
+      return *this;
+    }
+    if (shift < sizeof(SmallInteger) * CHAR_BIT - 1u) {
+      SmallInteger const shifted = static_cast<SmallInteger>(static_cast<unsigned __int128>(value) << shift);
+      if (shifted >> shift == value) {
+        storage_.small = shifted;
+        return *this;
+      }
+    }
+  }
+  promote_();
+  mpz_mul_2exp(storage_.big, storage_.big, shift);
+  return *this;
 }
 
-Integer &Integer::setToRandom(IntegerRandomState &state, Integer const &upper)
+Integer Integer::operator<<(std::size_t const shift) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  Integer result(*this);
+  result <<= shift;
+  return result;
+}
+
+Integer &Integer::operator>>=(std::size_t const shift)
+{
+  if (is_small_) {
+    if (shift >= sizeof(SmallInteger) * CHAR_BIT) {
+      storage_.small = storage_.small < 0 ? -1 : 0;
+    }
+    else {
+      storage_.small >>= shift;
+    }
+    return *this;
+  }
+  mpz_fdiv_q_2exp(storage_.big, storage_.big, shift);
+  return *this;
+}
+
+Integer Integer::operator>>(std::size_t const shift) const
+{
+  Integer result(*this);
+  result >>= shift;
+  return result;
+}
+
+std::size_t Integer::bitLength() const noexcept
+{
+  if (is_small_) {
+    SmallInteger const value = storage_.small;
+    unsigned __int128 const magnitude
+      = value < 0 ? -static_cast<unsigned __int128>(value) : static_cast<unsigned __int128>(value);
+    auto const high = static_cast<unsigned long long>(magnitude >> 64u);
+    if (high != 0u) {
+      return 128u - __builtin_clzll(high);
+    }
+    auto const low = static_cast<unsigned long long>(magnitude);
+    return low != 0u ? 64u - __builtin_clzll(low) : 0u;
+  }
+  return mpz_sgn(storage_.big) == 0 ? 0u : mpz_sizeinbase(storage_.big, 2);
+}
+
+bool Integer::testBit(std::size_t const index) const noexcept
+{
+  if (is_small_) {
+    if (index >= sizeof(SmallInteger) * CHAR_BIT) {
+      return storage_.small < 0;
+    }
+    return (static_cast<unsigned __int128>(storage_.small) >> index & 1u) != 0u;
+  }
+  return mpz_tstbit(storage_.big, index) != 0;
+}
+
+void Integer::exportBits(unsigned char * const buffer, std::size_t const num_bits, BitOrder const order) const
+{
+  if (*this < 0l) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("A negative integer cannot be exported.");
+  }
+  if (bitLength() > num_bits) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`num_bits` is too small to hold the integer.");
+  }
+
+  std::size_t const num_bytes = (num_bits + 7u) / 8u;
+  std::fill_n(buffer, num_bytes, 0u);
+  if (order == BitOrder::least_significant_first) {
+    View_ const view(*this);
+    mpz_export(buffer, nullptr, -1, 1, 0, 0, view.get());
+    return;
+  }
+
+  auto const write = [&](Integer const &value) {
+    std::size_t const count = (value.bitLength() + 7u) / 8u;
+    View_ const view(value);
+    mpz_export(buffer + (num_bytes - count), nullptr, 1, 1, 0, 0, view.get());
+  };
+  std::size_t const padding = num_bytes * 8u - num_bits;
+  if (padding == 0u) {
+    write(*this);
+  }
+  else {
+    write(*this << padding);
+  }
+}
+
+Integer &Integer::importBits(unsigned char const * const buffer, std::size_t const num_bits, BitOrder const order)
+{
+  std::size_t const num_bytes = (num_bits + 7u) / 8u;
+  std::size_t const padding = num_bytes * 8u - num_bits;
+
+  if (is_small_ && num_bits < sizeof(SmallInteger) * CHAR_BIT) {
+    unsigned __int128 value = 0u;
+    if (order == BitOrder::most_significant_first) {
+      for (std::size_t i = 0u; i < num_bytes; ++i) {
+        value = value << 8u | buffer[i];
+      }
+      value >>= padding;
+    }
+    else {
+      for (std::size_t i = num_bytes; i > 0u; --i) {
+        value = value << 8u | buffer[i - 1u];
+      }
+      value &= (static_cast<unsigned __int128>(1u) << num_bits) - 1u;
+    }
+    storage_.small = static_cast<SmallInteger>(value);
+    return *this;
+  }
+
+  promote_();
+  if (order == BitOrder::most_significant_first) {
+    mpz_import(storage_.big, num_bytes, 1, 1, 0, 0, buffer);
+    mpz_fdiv_q_2exp(storage_.big, storage_.big, padding);
+  }
+  else {
+    mpz_import(storage_.big, num_bytes, -1, 1, 0, 0, buffer);
+    mpz_fdiv_r_2exp(storage_.big, storage_.big, num_bits);
   }
+  return *this;
+}
+
+Integer &Integer::setToRandom(IntegerRandomState &state, Integer const &upper)
+{
   if (!state.p_impl_) {
     IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`state` is stale.");
   }
-  if (!upper.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`upper` is stale.");
-  }
   if (upper <= 0ul) {
     IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`upper` must be positive.");
   }
-  p_impl_->setToRandom(state.p_impl_->get(), *upper.p_impl_);
+  IntegerRandomState::Impl_ &impl = *state.p_impl_;
+  if (!impl.isCounterBased()) {
+    View_ const upper_view(upper);
+    promote_();
+    mpz_urandomm(storage_.big, impl.get(), upper_view.get());
+    return *this;
+  }
+
+  IsMajsoulFair::UniformIntegerSampler(upper).sample(state, *this);
   return *this;
 }
 
@@ -526,57 +843,85 @@ Integer &Integer::setToRandom(
 
 Integer::operator unsigned long() const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }
   if (*this < 0ul) {
     IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
   }
   if (*this > ULONG_MAX) {
     IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
   }
-  return static_cast<unsigned long>(*p_impl_);
+  return is_small_ ? static_cast<unsigned long>(storage_.small) : mpz_get_ui(storage_.big);
 }
 
 Integer::operator long() const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }
   if (*this < LONG_MIN) {
     IS_MAJSOUL_FAIR_THROW<std::underflow_error>("Underflow occurred.");
   }
   if (*this > LONG_MAX) {
     IS_MAJSOUL_FAIR_THROW<std::overflow_error>("Overflow occurred.");
   }
-  return static_cast<long>(*p_impl_);
+  return is_small_ ? static_cast<long>(storage_.small) : mpz_get_si(storage_.big);
 }
 
-bool Integer::operator==(Integer const &rhs) const
+int Integer::compareWithSum(Integer const &lhs, Integer const &rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_ && lhs.is_small_ && rhs.is_small_) {
+    SmallInteger sum;
+    if (!__builtin_add_overflow(lhs.storage_.small, rhs.storage_.small, &sum)) {
+      return (storage_.small > sum) - (storage_.small < sum);
+    }
+  }
+
+  View_ const this_view(*this);
+  View_ const lhs_view(lhs);
+  View_ const rhs_view(rhs);
+  mpz_srcptr larger = lhs_view.get();
+  mpz_srcptr smaller = rhs_view.get();
+  if (mpz_size(larger) < mpz_size(smaller)) {
+    std::swap(larger, smaller);
+  }
+  mp_size_t const larger_size = mpz_size(larger);
+  mp_size_t const smaller_size = mpz_size(smaller);
+  if (smaller_size == 0) {
+    return sign(mpz_cmp(this_view.get(), larger));
   }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
+  if (mpz_sgn(larger) > 0 && mpz_sgn(smaller) > 0 && larger_size < max_stack_limbs) {
+    std::array<mp_limb_t, max_stack_limbs> sum_limbs;
+    mp_limb_t const carry = mpn_add(
+      sum_limbs.data(), mpz_limbs_read(larger), larger_size, mpz_limbs_read(smaller), smaller_size);
+    sum_limbs[larger_size] = carry;
+    mpz_t sum;
+    mpz_roinit_n(sum, sum_limbs.data(), larger_size + (carry != 0u ? 1 : 0));
+    return sign(mpz_cmp(this_view.get(), sum));
   }
-  return *p_impl_ == *rhs.p_impl_;
+
+  Integer sum(lhs);
+  sum += rhs;
+  return sign(mpz_cmp(this_view.get(), View_(sum).get()));
+}
+
+bool Integer::operator==(Integer const &rhs) const
+{
+  if (is_small_ && rhs.is_small_) {
+    return storage_.small == rhs.storage_.small;
+  }
+  return mpz_cmp(View_(*this).get(), View_(rhs).get()) == 0;
 }
 
 bool Integer::operator==(unsigned long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small == static_cast<SmallInteger>(rhs);
   }
-  return *p_impl_ == rhs;
+  return mpz_cmp_ui(storage_.big, rhs) == 0;
 }
 
 bool Integer::operator==(long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small == rhs;
   }
-  return *p_impl_ == rhs;
+  return mpz_cmp_si(storage_.big, rhs) == 0;
 }
 
 bool Integer::operator!=(Integer const &rhs) const
@@ -596,29 +941,26 @@ bool Integer::operator!=(long const rhs) const
 
 bool Integer::operator<(Integer const &rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }
-  if (!rhs.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rhs` is stale.");
+  if (is_small_ && rhs.is_small_) {
+    return storage_.small < rhs.storage_.small;
   }
-  return *p_impl_ < *rhs.p_impl_;
+  return mpz_cmp(View_(*this).get(), View_(rhs).get()) < 0;
 }
 
 bool Integer::operator<(unsigned long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small < static_cast<SmallInteger>(rhs);
   }
-  return *p_impl_ < rhs;
+  return mpz_cmp_ui(storage_.big, rhs) < 0;
 }
 
 bool Integer::operator<(long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small < rhs;
   }
-  return *p_impl_ < rhs;
+  return mpz_cmp_si(storage_.big, rhs) < 0;
 }
 
 bool Integer::operator<=(Integer const &rhs) const
@@ -628,18 +970,18 @@ bool Integer::operator<=(Integer const &rhs) const
 
 bool Integer::operator<=(unsigned long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small <= static_cast<SmallInteger>(rhs);
   }
-  return *p_impl_ <= rhs;
+  return mpz_cmp_ui(storage_.big, rhs) <= 0;
 }
 
 bool Integer::operator<=(long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }  
-  return *p_impl_ <= rhs;
+  if (is_small_) {
+    return storage_.small <= rhs;
+  }
+  return mpz_cmp_si(storage_.big, rhs) <= 0;
 }
 
 bool Integer::operator>(Integer const &rhs) const
@@ -649,18 +991,18 @@ bool Integer::operator>(Integer const &rhs) const
 
 bool Integer::operator>(unsigned long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small > static_cast<SmallInteger>(rhs);
   }
-  return *p_impl_ > rhs;
+  return mpz_cmp_ui(storage_.big, rhs) > 0;
 }
 
 bool Integer::operator>(long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
-  }  
-  return *p_impl_ > rhs;
+  if (is_small_) {
+    return storage_.small > rhs;
+  }
+  return mpz_cmp_si(storage_.big, rhs) > 0;
 }
 
 bool Integer::operator>=(Integer const &rhs) const
@@ -670,18 +1012,28 @@ bool Integer::operator>=(Integer const &rhs) const
 
 bool Integer::operator>=(unsigned long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small >= static_cast<SmallInteger>(rhs);
   }
-  return *p_impl_ >= rhs;
+  return mpz_cmp_ui(storage_.big, rhs) >= 0;
 }
 
 bool Integer::operator>=(long const rhs) const
 {
-  if (!p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  if (is_small_) {
+    return storage_.small >= rhs;
+  }
+  return mpz_cmp_si(storage_.big, rhs) >= 0;
+}
+
+void Integer::promote_()
+{
+  if (!is_small_) {
+    return;
   }
-  return *p_impl_ >= rhs;
+  View_ const view(*this);
+  mpz_init_set(storage_.big, view.get());
+  is_small_ = false;
 }
 
 void swap(Integer &lhs, Integer &rhs) noexcept
@@ -731,16 +1083,36 @@ Integer operator%(unsigned long const lhs, Integer const &rhs)
 
 double divideAsDouble(Integer const &numerator, Integer const &denominator)
 {
-  if (!numerator.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`numerator` is stale.");
+  if (denominator == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`denominator` must not be zero.");
   }
-  if (!denominator.p_impl_) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`denominator` is stale.");
+
+  long int exp = 0;
+  double const mantissa = mpz_get_d_2exp(&exp, Integer::View_(numerator).get());
+
+  long int denominator_exp = 0;
+  double const denominator_mantissa = mpz_get_d_2exp(&denominator_exp, Integer::View_(denominator).get());
+
+  exp -= denominator_exp;
+  return (mantissa / denominator_mantissa) * std::pow(2.0, exp);
+}
+
+double log2OfQuotient(Integer const &numerator, Integer const &denominator)
+{
+  if (numerator == 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`numerator` must not be zero.");
   }
   if (denominator == 0ul) {
     IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`denominator` must not be zero.");
   }
-  return numerator.p_impl_->divideAsDouble(*denominator.p_impl_);
+
+  long int exp = 0;
+  double const mantissa = mpz_get_d_2exp(&exp, Integer::View_(numerator).get());
+
+  long int denominator_exp = 0;
+  double const denominator_mantissa = mpz_get_d_2exp(&denominator_exp, Integer::View_(denominator).get());
+
+  return std::log2(mantissa / denominator_mantissa) + static_cast<double>(exp - denominator_exp);
 }
 
 bool operator==(unsigned long const lhs, Integer const &rhs)
@@ -807,6 +1179,10 @@ IntegerRandomState::IntegerRandomState()
   : p_impl_(std::make_shared<Impl_>())
 {}
 
+IntegerRandomState::IntegerRandomState(std::array<std::uint64_t, 2u> const &seed, std::uint64_t const stream)
+  : p_impl_(std::make_shared<Impl_>(seed, stream))
+{}
+
 IntegerRandomState::IntegerRandomState(IntegerRandomState &&other) noexcept
   : p_impl_(std::move(other.p_impl_))
 {
@@ -829,6 +1205,31 @@ IntegerRandomState &IntegerRandomState::operator=(IntegerRandomState &&other) no
   return *this;
 }
 
+IntegerRandomState::result_type IntegerRandomState::operator()()
+{
+  if (!p_impl_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  }
+  return p_impl_->next();
+}
+
+void IntegerRandomState::generate(result_type * const first, result_type * const last)
+{
+  if (!p_impl_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  }
+  static_assert(sizeof(result_type) == sizeof(std::uint64_t));
+  p_impl_->generate(reinterpret_cast<std::uint64_t *>(first), reinterpret_cast<std::uint64_t *>(last));
+}
+
+void IntegerRandomState::jump(unsigned long long const n)
+{
+  if (!p_impl_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`*this` is stale.");
+  }
+  p_impl_->jump(n);
+}
+
 void swap(IntegerRandomState &lhs, IntegerRandomState &rhs) noexcept
 {
   lhs.swap(rhs);
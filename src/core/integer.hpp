@@ -5,17 +5,38 @@
 #if !defined(CORE_INTEGER_HPP)
 #define CORE_INTEGER_HPP
 
+#include <gmp.h>
 #include <memory>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <climits>
 
 
 namespace IsMajsoulFair{
 
 class IntegerRandomState;
 
+class UniformIntegerSampler;
+
+// The order in which `Integer::exportBits` and `Integer::importBits` lay bits
+// out in a byte buffer. `most_significant_first` is big-endian with the first
+// bit in the top of the first byte; `least_significant_first` is
+// little-endian with the first bit in the bottom of the first byte.
+enum class BitOrder
+{
+  most_significant_first,
+  least_significant_first
+}; // enum class BitOrder
+
 class Integer;
 
 double divideAsDouble(Integer const &numerator, Integer const &denominator);
 
+// `log2(numerator / denominator)`, which stays finite where the quotient
+// itself would underflow a `double`.
+double log2OfQuotient(Integer const &numerator, Integer const &denominator);
+
 class Integer
 {
 public:
@@ -29,6 +50,8 @@ public:
 
   Integer(Integer &&other) noexcept;
 
+  ~Integer();
+
   void swap(Integer &other) noexcept;
 
   void swap(Integer &&other) noexcept;
@@ -93,10 +116,46 @@ public:
 
   Integer operator%(unsigned long rhs) const;
 
+  // `*this += lhs * rhs` without materializing the product.
+  Integer &addmul(Integer const &lhs, Integer const &rhs);
+
+  Integer &addmul(Integer const &lhs, unsigned long rhs);
+
+  // `*this -= lhs * rhs` without materializing the product.
+  Integer &submul(Integer const &lhs, Integer const &rhs);
+
+  Integer &submul(Integer const &lhs, unsigned long rhs);
+
+  // Pre-sizes the value to hold `bits` bits without further reallocation.
+  void reserve(std::size_t bits);
+
   Integer &inplacePow(unsigned long exponent);
 
   Integer pow(unsigned long exponent) const;
 
+  Integer &operator<<=(std::size_t shift);
+
+  Integer operator<<(std::size_t shift) const;
+
+  // Rounds toward negative infinity.
+  Integer &operator>>=(std::size_t shift);
+
+  Integer operator>>(std::size_t shift) const;
+
+  // The number of bits in the absolute value; zero for zero.
+  std::size_t bitLength() const noexcept;
+
+  // Two's complement semantics for negative values.
+  bool testBit(std::size_t index) const noexcept;
+
+  // Writes the value, which must be non-negative and fit in `num_bits` bits,
+  // as `num_bits` bits into `(num_bits + 7) / 8` bytes of `buffer`. Padding
+  // bits are zero.
+  void exportBits(unsigned char *buffer, std::size_t num_bits, BitOrder order) const;
+
+  // The inverse of `exportBits`. Padding bits are ignored.
+  Integer &importBits(unsigned char const *buffer, std::size_t num_bits, BitOrder order);
+
   Integer &setToRandom(IntegerRandomState &state, Integer const &upper);
 
   Integer &setToRandom(IntegerRandomState &state, Integer const &lower, Integer const &upper);
@@ -107,6 +166,11 @@ public:
 
   friend double IsMajsoulFair::divideAsDouble(Integer const &numerator, Integer const &denominator);
 
+  friend double IsMajsoulFair::log2OfQuotient(Integer const &numerator, Integer const &denominator);
+
+  // Returns the sign of `*this - (lhs + rhs)` without materializing the sum.
+  int compareWithSum(Integer const &lhs, Integer const &rhs) const;
+
   bool operator==(Integer const &rhs) const;
 
   bool operator==(unsigned long rhs) const;
@@ -144,8 +208,23 @@ public:
   bool operator>=(long rhs) const;
 
 private:
-  class Impl_;
-  std::shared_ptr<Impl_> p_impl_;
+  friend class IsMajsoulFair::UniformIntegerSampler;
+
+  class View_;
+
+  void promote_();
+
+  // A value stays in `small` until an operation overflows 128 bits, and then
+  // lives in `big` for the rest of its lifetime so that the limbs GMP has
+  // allocated are reused by later operations.
+  union Storage_
+  {
+    __int128 small;
+    mpz_t big;
+  }; // union Storage_
+
+  bool is_small_;
+  Storage_ storage_;
 }; // class Integer
 
 void swap(Integer &lhs, Integer &rhs) noexcept;
@@ -196,8 +275,27 @@ private:
   friend class Integer;
 
 public:
+  using result_type = unsigned long;
+
+  static constexpr result_type min() noexcept
+  {
+    return 0u;
+  }
+
+  static constexpr result_type max() noexcept
+  {
+    return ULONG_MAX;
+  }
+
+  // An unseeded Mersenne Twister, which yields the same sequence in every
+  // run.
   IntegerRandomState();
 
+  // A Philox4x64-10 counter-based generator keyed by the 128-bit `seed`.
+  // Distinct `stream`s under the same seed never overlap, so they can be
+  // handed out to worker threads.
+  explicit IntegerRandomState(std::array<std::uint64_t, 2u> const &seed, std::uint64_t stream = 0u);
+
   IntegerRandomState(IntegerRandomState const &) = delete;
 
   IntegerRandomState(IntegerRandomState &&other) noexcept;
@@ -210,6 +308,15 @@ public:
 
   IntegerRandomState &operator=(IntegerRandomState &&other) noexcept;
 
+  result_type operator()();
+
+  // Equivalent to `std::generate(first, last, std::ref(*this))`.
+  void generate(result_type *first, result_type *last);
+
+  // Skips the next `n` outputs in constant time. Only counter-based states
+  // support this.
+  void jump(unsigned long long n);
+
 private:
   class Impl_;
   std::shared_ptr<Impl_> p_impl_;
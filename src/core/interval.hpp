@@ -6,47 +6,195 @@
 #define CORE_INTERVAL_HPP
 
 #include "integer.hpp"
+#include "../common/throw.hpp"
+#include <utility>
+#include <stdexcept>
 
 
 namespace IsMajsoulFair{
 
-class Interval
+template<typename IntegerType>
+class BasicInterval
 {
 public:
-  Interval(
-    IsMajsoulFair::Integer const &denominator,
-    IsMajsoulFair::Integer const &lower_numerator,
-    IsMajsoulFair::Integer const &upper_numerator);
+  using integer_type = IntegerType;
 
-  Interval(Interval const &other);
+  // The unit interval `[0, 1)`.
+  BasicInterval();
 
-  Interval(Interval &&other) noexcept;
+  BasicInterval(
+    IntegerType const &denominator,
+    IntegerType const &lower_numerator,
+    IntegerType const &upper_numerator);
 
-  void swap(Interval &other) noexcept;
+  BasicInterval(BasicInterval const &other);
 
-  void swap(Interval &&other) noexcept;
+  BasicInterval(BasicInterval &&other) noexcept;
 
-  Interval &operator=(Interval const &other);
+  void swap(BasicInterval &other) noexcept;
 
-  Interval &operator=(Interval &&other) noexcept;
+  void swap(BasicInterval &&other) noexcept;
 
-  IsMajsoulFair::Integer const &getDenominator() const noexcept;
+  BasicInterval &operator=(BasicInterval const &other);
 
-  IsMajsoulFair::Integer const &getLowerNumerator() const noexcept;
+  BasicInterval &operator=(BasicInterval &&other) noexcept;
 
-  IsMajsoulFair::Integer const &getUpperNumerator() const noexcept;
+  // Overwrites the interval in place, reusing the storage of its integers.
+  void assign(
+    IntegerType const &denominator,
+    IntegerType const &lower_numerator,
+    IntegerType const &upper_numerator);
+
+  IntegerType const &getDenominator() const noexcept;
+
+  IntegerType const &getLowerNumerator() const noexcept;
+
+  IntegerType const &getUpperNumerator() const noexcept;
 
 private:
-  IsMajsoulFair::Integer denominator_;
-  IsMajsoulFair::Integer lower_numerator_;
-  IsMajsoulFair::Integer upper_numerator_;
-}; // class Interval
+  void check_() const;
+
+  IntegerType denominator_;
+  IntegerType lower_numerator_;
+  IntegerType upper_numerator_;
+}; // class BasicInterval
+
+using Interval = BasicInterval<IsMajsoulFair::Integer>;
+
+template<typename IntegerType>
+void swap(BasicInterval<IntegerType> &lhs, BasicInterval<IntegerType> &rhs) noexcept;
+
+template<typename IntegerType>
+void swap(BasicInterval<IntegerType> &lhs, BasicInterval<IntegerType> &&rhs) noexcept;
+
+template<typename IntegerType>
+void swap(BasicInterval<IntegerType> &&lhs, BasicInterval<IntegerType> &rhs) noexcept;
 
-void swap(Interval &lhs, Interval &rhs) noexcept;
+template<typename IntegerType>
+BasicInterval<IntegerType>::BasicInterval()
+  : denominator_(1ul), lower_numerator_(0ul), upper_numerator_(1ul)
+{}
 
-void swap(Interval &lhs, Interval &&rhs) noexcept;
+template<typename IntegerType>
+BasicInterval<IntegerType>::BasicInterval(
+  IntegerType const &denominator,
+  IntegerType const &lower_numerator,
+  IntegerType const &upper_numerator)
+  : denominator_(denominator), lower_numerator_(lower_numerator), upper_numerator_(upper_numerator)
+{
+  check_();
+}
+
+template<typename IntegerType>
+BasicInterval<IntegerType>::BasicInterval(BasicInterval const &other) = default;
+
+template<typename IntegerType>
+BasicInterval<IntegerType>::BasicInterval(BasicInterval &&other) noexcept = default;
+
+template<typename IntegerType>
+void BasicInterval<IntegerType>::swap(BasicInterval &other) noexcept
+{
+  using std::swap;
+  swap(denominator_, other.denominator_);
+  swap(lower_numerator_, other.lower_numerator_);
+  swap(upper_numerator_, other.upper_numerator_);
+}
+
+template<typename IntegerType>
+void BasicInterval<IntegerType>::swap(BasicInterval &&other) noexcept
+{
+  swap(other);
+}
+
+template<typename IntegerType>
+BasicInterval<IntegerType> &BasicInterval<IntegerType>::operator=(BasicInterval const &other)
+{
+  BasicInterval(other).swap(*this);
+  return *this;
+}
+
+template<typename IntegerType>
+BasicInterval<IntegerType> &BasicInterval<IntegerType>::operator=(BasicInterval &&other) noexcept
+{
+  BasicInterval(std::move(other)).swap(*this);
+  return *this;
+}
+
+template<typename IntegerType>
+void BasicInterval<IntegerType>::assign(
+  IntegerType const &denominator,
+  IntegerType const &lower_numerator,
+  IntegerType const &upper_numerator)
+{
+  denominator_ = denominator;
+  lower_numerator_ = lower_numerator;
+  upper_numerator_ = upper_numerator;
+  check_();
+}
+
+template<typename IntegerType>
+IntegerType const &BasicInterval<IntegerType>::getDenominator() const noexcept
+{
+  return denominator_;
+}
+
+template<typename IntegerType>
+IntegerType const &BasicInterval<IntegerType>::getLowerNumerator() const noexcept
+{
+  return lower_numerator_;
+}
+
+template<typename IntegerType>
+IntegerType const &BasicInterval<IntegerType>::getUpperNumerator() const noexcept
+{
+  return upper_numerator_;
+}
+
+template<typename IntegerType>
+void BasicInterval<IntegerType>::check_() const
+{
+  if (denominator_ <= 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`denominator` must be positive.");
+  }
+  if (lower_numerator_ < 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`lower_numerator` must be non-negative.");
+  }
+  if (upper_numerator_ < 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`upper_numerator` must be non-negative.");
+  }
+  if (lower_numerator_ > denominator_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(
+      "`lower_numerator` must be less than or equal to `denominator`.");
+  }
+  if (upper_numerator_ > denominator_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(
+      "`upper_numerator` must be less than or equal to `denominator`.");
+  }
+  if (upper_numerator_ < lower_numerator_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(
+      "`upper_numerator` must be greater than or equal to `lower_numerator`.");
+  }
+}
+
+template<typename IntegerType>
+void swap(BasicInterval<IntegerType> &lhs, BasicInterval<IntegerType> &rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+template<typename IntegerType>
+void swap(BasicInterval<IntegerType> &lhs, BasicInterval<IntegerType> &&rhs) noexcept
+{
+  lhs.swap(rhs);
+}
+
+template<typename IntegerType>
+void swap(BasicInterval<IntegerType> &&lhs, BasicInterval<IntegerType> &rhs) noexcept
+{
+  lhs.swap(rhs);
+}
 
-void swap(Interval &&lhs, Interval &rhs) noexcept;
+extern template class BasicInterval<IsMajsoulFair::Integer>;
 
 } // namespace IsMajsoulFair
 
@@ -5,17 +5,117 @@
 #if !defined(CORE_INTERVAL_TO_BINARY_HPP)
 #define CORE_INTERVAL_TO_BINARY_HPP
 
+#include "covering_binary_interval.hpp"
+#include "paishan_coding_context.hpp"
 #include "interval.hpp"
 #include "integer.hpp"
+#include "../common/throw.hpp"
 #include <vector>
+#include <stdexcept>
+#include <cstdint>
 #include <cstddef>
 
 
 namespace IsMajsoulFair{
 
+namespace Detail_{
+
+template<typename IntegerType>
+std::vector<unsigned char> integerToBinary(IntegerType const &integer, std::size_t const num_bits)
+{
+  std::vector<unsigned char> bytes((num_bits + 7u) / 8u);
+  integer.exportBits(bytes.data(), num_bits, IsMajsoulFair::BitOrder::most_significant_first);
+
+  std::vector<unsigned char> result(num_bits);
+  for (std::size_t i = 0u; i < num_bits; ++i) {
+    result[i] = bytes[i / 8u] >> (7u - i % 8u) & 1u;
+  }
+  return result;
+}
+
+} // namespace Detail_
+
+// Returns the leading `num_bits` bits of a point drawn uniformly from
+// `interval`. The point lies in one of the binary words `[lower, upper)` that
+// cover `interval`; every interior word is covered whole, with mass
+// `interval.getDenominator()`, so only the two edge masses are computed, and
+// the interior word is found with one division. Time and memory do not
+// depend on the number of the words.
+//
+// `binary_denominator` must be `2^num_bits`; the overloads below pass it.
+template<typename IntegerType>
+std::vector<unsigned char> intervalToBinary(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval,
+  std::size_t const num_bits,
+  IntegerType const &binary_denominator,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  auto const [lower_binary, upper_binary] = IsMajsoulFair::getCoveringBinaryInterval(interval, num_bits);
+
+  if (upper_binary - lower_binary == 1ul) {
+    return Detail_::integerToBinary(lower_binary, num_bits);
+  }
+
+  IntegerType lower_mass = interval.getDenominator();
+  lower_mass.addmul(lower_binary, interval.getDenominator());
+  lower_mass.submul(interval.getLowerNumerator(), binary_denominator);
+  if (lower_mass <= 0l) {
+    IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+  }
+  IntegerType const interior_mass = (upper_binary - lower_binary - 2ul) * interval.getDenominator();
+
+  // Masses are laid out as the lower edge, the interior words and the upper
+  // edge, in the order of the words.
+  IntegerType random_value;
+  random_value.setToRandom(
+    state, (interval.getUpperNumerator() - interval.getLowerNumerator()) * binary_denominator);
+  if (random_value < lower_mass) {
+    return Detail_::integerToBinary(lower_binary, num_bits);
+  }
+  random_value -= lower_mass;
+  if (random_value < interior_mass) {
+    random_value /= interval.getDenominator();
+    random_value += lower_binary;
+    random_value += 1ul;
+    return Detail_::integerToBinary(random_value, num_bits);
+  }
+  return Detail_::integerToBinary(upper_binary - 1ul, num_bits);
+}
+
+template<typename IntegerType>
 std::vector<unsigned char> intervalToBinary(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval,
+  std::size_t const num_bits,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  return IsMajsoulFair::intervalToBinary(interval, num_bits, IntegerType(1ul) << num_bits, state);
+}
+
+// Takes `2^num_bits` from `context`.
+template<typename IntegerType>
+std::vector<unsigned char> intervalToBinary(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval,
+  IsMajsoulFair::BasicPaishanCodingContext<IntegerType> const &context,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  return IsMajsoulFair::intervalToBinary(
+    interval, context.getNumBits(), context.getBinaryDenominator(), state);
+}
+
+extern template std::vector<unsigned char> intervalToBinary(
   IsMajsoulFair::Interval const &interval,
   std::size_t num_bits,
+  IsMajsoulFair::Integer const &binary_denominator,
+  IsMajsoulFair::IntegerRandomState &state);
+
+extern template std::vector<unsigned char> intervalToBinary(
+  IsMajsoulFair::Interval const &interval,
+  std::size_t num_bits,
+  IsMajsoulFair::IntegerRandomState &state);
+
+extern template std::vector<unsigned char> intervalToBinary(
+  IsMajsoulFair::Interval const &interval,
+  IsMajsoulFair::PaishanCodingContext const &context,
   IsMajsoulFair::IntegerRandomState &state);
 
 } // namespace IsMajsoulFair
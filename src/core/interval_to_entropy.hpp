@@ -5,13 +5,165 @@
 #if !defined(CORE_INTERVAL_TO_ENTROPY_HPP)
 #define CORE_INTERVAL_TO_ENTROPY_HPP
 
+#include "covering_binary_interval.hpp"
+#include "paishan_coding_context.hpp"
 #include "interval.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <span>
+#include <stdexcept>
 #include <cstddef>
 
 
 namespace IsMajsoulFair{
 
-double intervalToEntropy(IsMajsoulFair::Interval const &interval, std::size_t const num_bits);
+namespace Detail_{
+
+// The entropy of the covering words of an interval with denominator
+// `denominator`, given the masses of its lower and upper edge words out of
+// `denominator` each, and the number of the words.
+template<typename IntegerType>
+double coveringEntropy(
+  IntegerType const &denominator,
+  IntegerType const &lower_mass,
+  IntegerType const &upper_mass,
+  IntegerType const &num_words)
+{
+  if (lower_mass <= 0l || upper_mass <= 0l) {
+    IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+  }
+
+  IntegerType const normalizer = num_words * denominator;
+
+  // Every interior word is covered whole, so its term is the same, and the
+  // interior words add up to `(k - 2) p log2 p` for `k = upper - lower` and
+  // `p = 1 / k`. Each term is `-p log2 p` with `log2 p` taken from the
+  // exponents, so that tiny edge probabilities never underflow to `0 log2 0`.
+  auto const term = [&](IntegerType const &probability_mass, IntegerType const &total_mass) {
+    double const log2_prob = IsMajsoulFair::log2OfQuotient(probability_mass, normalizer);
+    return -IsMajsoulFair::divideAsDouble(total_mass, normalizer) * log2_prob;
+  };
+
+  double entropy = term(lower_mass, lower_mass);
+  if (num_words > 2ul) {
+    IntegerType const interior_mass = (num_words - 2ul) * denominator;
+    entropy += term(denominator, interior_mass);
+  }
+  entropy += term(upper_mass, upper_mass);
+  return entropy;
+}
+
+} // namespace Detail_
+
+// `binary_denominator` must be `2^num_bits`; the overloads below pass it.
+template<typename IntegerType>
+double intervalToEntropy(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval,
+  std::size_t const num_bits,
+  IntegerType const &binary_denominator)
+{
+  auto const [lower_binary, upper_binary] = IsMajsoulFair::getCoveringBinaryInterval(interval, num_bits);
+
+  if (upper_binary - lower_binary == 1ul) {
+    if (lower_binary * interval.getDenominator() > interval.getLowerNumerator() * binary_denominator) {
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    }
+    if (upper_binary * interval.getDenominator() < interval.getUpperNumerator() * binary_denominator) {
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    }
+    return 0.0;
+  }
+
+  IntegerType lower_mass = interval.getDenominator();
+  lower_mass.addmul(lower_binary, interval.getDenominator());
+  lower_mass.submul(interval.getLowerNumerator(), binary_denominator);
+  IntegerType upper_mass = interval.getDenominator();
+  upper_mass.addmul(interval.getUpperNumerator(), binary_denominator);
+  upper_mass.submul(upper_binary, interval.getDenominator());
+  return Detail_::coveringEntropy(
+    interval.getDenominator(), lower_mass, upper_mass, IntegerType(upper_binary - lower_binary));
+}
+
+template<typename IntegerType>
+double intervalToEntropy(IsMajsoulFair::BasicInterval<IntegerType> const &interval, std::size_t const num_bits)
+{
+  return IsMajsoulFair::intervalToEntropy(interval, num_bits, IntegerType(1ul) << num_bits);
+}
+
+// Takes `2^num_bits` from `context`.
+template<typename IntegerType>
+double intervalToEntropy(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval,
+  IsMajsoulFair::BasicPaishanCodingContext<IntegerType> const &context)
+{
+  return IsMajsoulFair::intervalToEntropy(interval, context.getNumBits(), context.getBinaryDenominator());
+}
+
+// Writes `intervalToEntropy(interval, first_num_bits + i)` to `entropies[i]`
+// for every `i`. The covering words at `n + 1` bits follow from those at `n`
+// bits by doubling both ends and carrying one remainder bit each, so the
+// interval is scaled only once.
+template<typename IntegerType>
+void intervalToEntropies(
+  IsMajsoulFair::BasicInterval<IntegerType> const &interval,
+  std::size_t const first_num_bits,
+  std::span<double> const entropies)
+{
+  if (entropies.empty()) {
+    return;
+  }
+
+  IntegerType const &denominator = interval.getDenominator();
+  auto const [lower_binary, upper_binary] = IsMajsoulFair::getCoveringBinaryInterval(interval, first_num_bits);
+  // `lower_remainder = L 2^n - lower D` and `upper_remainder = upper D - U 2^n`,
+  // both in `[0, D)`.
+  IntegerType lower_remainder = interval.getLowerNumerator() << first_num_bits;
+  lower_remainder.submul(lower_binary, denominator);
+  IntegerType upper_remainder = upper_binary * denominator;
+  upper_remainder -= interval.getUpperNumerator() << first_num_bits;
+  IntegerType num_words = upper_binary - lower_binary;
+
+  IntegerType lower_mass;
+  IntegerType upper_mass;
+  for (std::size_t i = 0u;; ++i) {
+    if (num_words == 1ul) {
+      entropies[i] = 0.0;
+    }
+    else {
+      lower_mass = denominator;
+      lower_mass -= lower_remainder;
+      upper_mass = denominator;
+      upper_mass -= upper_remainder;
+      entropies[i] = Detail_::coveringEntropy(denominator, lower_mass, upper_mass, num_words);
+    }
+    if (i + 1u == entropies.size()) {
+      break;
+    }
+
+    num_words <<= 1u;
+    lower_remainder <<= 1u;
+    if (lower_remainder >= denominator) {
+      lower_remainder -= denominator;
+      num_words -= 1ul;
+    }
+    upper_remainder <<= 1u;
+    if (upper_remainder >= denominator) {
+      upper_remainder -= denominator;
+      num_words -= 1ul;
+    }
+  }
+}
+
+extern template double intervalToEntropy(
+  IsMajsoulFair::Interval const &interval, std::size_t num_bits, IsMajsoulFair::Integer const &binary_denominator);
+
+extern template double intervalToEntropy(IsMajsoulFair::Interval const &interval, std::size_t num_bits);
+
+extern template double intervalToEntropy(
+  IsMajsoulFair::Interval const &interval, IsMajsoulFair::PaishanCodingContext const &context);
+
+extern template void intervalToEntropies(
+  IsMajsoulFair::Interval const &interval, std::size_t first_num_bits, std::span<double> entropies);
 
 } // namespace IsMajsoulFair
 
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "memory_mapped_file.hpp"
+
+#include "../common/throw.hpp"
+#include <filesystem>
+#include <span>
+#include <functional>
+#include <stdexcept>
+#include <cstddef>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+// Closes a file descriptor on every path out of the constructor.
+class FileDescriptor
+{
+public:
+  explicit FileDescriptor(int const fd) noexcept
+    : fd_(fd)
+  {}
+
+  FileDescriptor(FileDescriptor const &) = delete;
+
+  FileDescriptor &operator=(FileDescriptor const &) = delete;
+
+  ~FileDescriptor()
+  {
+    if (fd_ != -1) {
+      ::close(fd_);
+    }
+  }
+
+  int get() const noexcept
+  {
+    return fd_;
+  }
+
+private:
+  int fd_;
+}; // class FileDescriptor
+
+} // namespace <unnamed>
+
+namespace IsMajsoulFair{
+
+MemoryMappedFile::MemoryMappedFile(
+  std::filesystem::path const &path, IsMajsoulFair::MemoryMappedFileAccess const access)
+  : path_(path),
+    data_(nullptr),
+    size_(0u)
+{
+  FileDescriptor const fd(::open(path_.c_str(), O_RDONLY | O_CLOEXEC));
+  if (fd.get() == -1) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path_.string() << ": Failed to open.";
+  }
+  struct stat status;
+  if (::fstat(fd.get(), &status) == -1) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path_.string() << ": Failed to stat.";
+  }
+  std::size_t const size = static_cast<std::size_t>(status.st_size);
+  if (size == 0u) {
+    // `mmap` refuses an empty mapping.
+    return;
+  }
+
+  void * const mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd.get(), 0);
+  if (mapping == MAP_FAILED) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path_.string() << ": Failed to map.";
+  }
+  // Only a hint, so a failure is harmless.
+  ::madvise(
+    mapping, size, access == IsMajsoulFair::MemoryMappedFileAccess::random ? MADV_RANDOM : MADV_SEQUENTIAL);
+
+  data_ = static_cast<char const *>(mapping);
+  size_ = size;
+}
+
+MemoryMappedFile::~MemoryMappedFile()
+{
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char *>(data_), size_);
+  }
+}
+
+std::filesystem::path const &MemoryMappedFile::getPath() const noexcept
+{
+  return path_;
+}
+
+std::span<char const> MemoryMappedFile::getBytes() const noexcept
+{
+  return std::span<char const>(data_, size_);
+}
+
+} // namespace IsMajsoulFair
@@ -0,0 +1,49 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_MEMORY_MAPPED_FILE_HPP)
+#define CORE_MEMORY_MAPPED_FILE_HPP
+
+#include <filesystem>
+#include <span>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// How a mapping is going to be read, passed on to the kernel as a hint.
+enum class MemoryMappedFileAccess
+{
+  sequential,
+  random
+}; // enum class MemoryMappedFileAccess
+
+// A read-only memory mapping of a whole file. An empty file is mapped to an
+// empty span.
+class MemoryMappedFile
+{
+public:
+  explicit MemoryMappedFile(
+    std::filesystem::path const &path,
+    IsMajsoulFair::MemoryMappedFileAccess access = IsMajsoulFair::MemoryMappedFileAccess::sequential);
+
+  MemoryMappedFile(MemoryMappedFile const &) = delete;
+
+  MemoryMappedFile &operator=(MemoryMappedFile const &) = delete;
+
+  ~MemoryMappedFile();
+
+  std::filesystem::path const &getPath() const noexcept;
+
+  std::span<char const> getBytes() const noexcept;
+
+private:
+  std::filesystem::path path_;
+  char const *data_;
+  std::size_t size_;
+}; // class MemoryMappedFile
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_MEMORY_MAPPED_FILE_HPP)
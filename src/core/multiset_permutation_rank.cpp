@@ -0,0 +1,350 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "multiset_permutation_rank.hpp"
+
+#include "tile_set.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <vector>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+namespace{
+
+using std::placeholders::_1;
+
+constexpr std::size_t max_num_limbs = 16u;
+
+using Limbs = std::array<std::uint64_t, max_num_limbs>;
+
+constexpr void multiplyLimbs(Limbs &limbs, std::uint64_t const multiplier) noexcept
+{
+  std::uint64_t carry = 0u;
+  for (std::uint64_t &limb : limbs) {
+    unsigned __int128 const product = static_cast<unsigned __int128>(limb) * multiplier + carry;
+    limb = static_cast<std::uint64_t>(product);
+    carry = static_cast<std::uint64_t>(product >> 64u);
+  }
+}
+
+constexpr void divideLimbs(Limbs &limbs, std::uint64_t const divisor) noexcept
+{
+  std::uint64_t remainder = 0u;
+  for (std::size_t i = limbs.size(); i-- > 0u;) {
+    unsigned __int128 const dividend = static_cast<unsigned __int128>(remainder) << 64u | limbs[i];
+    limbs[i] = static_cast<std::uint64_t>(dividend / divisor);
+    remainder = static_cast<std::uint64_t>(dividend % divisor);
+  }
+}
+
+// Builds the multiset one tile at a time. Appending a tile to a multiset of
+// `n - 1` tiles, `c - 1` of which are of the same kind, multiplies the number
+// of the distinct permutations by `n / c`, which keeps every step exact.
+constexpr Limbs multinomialLimbs(std::array<std::uint_fast8_t, 37u> const &num_tiles) noexcept
+{
+  Limbs limbs{1u};
+  std::uint64_t n = 0u;
+  for (std::uint_fast8_t const num : num_tiles) {
+    for (std::uint64_t c = 1u; c <= num; ++c) {
+      multiplyLimbs(limbs, ++n);
+      divideLimbs(limbs, c);
+    }
+  }
+  return limbs;
+}
+
+template<typename TileSet>
+constexpr Limbs num_permutations = multinomialLimbs(TileSet::num_tiles_per_code);
+
+static_assert(num_permutations<IsMajsoulFair::FourPlayerTileSet>[max_num_limbs - 1u] == 0u);
+
+static_assert(num_permutations<IsMajsoulFair::ThreePlayerTileSet>[max_num_limbs - 1u] == 0u);
+
+IsMajsoulFair::Integer importLimbs(Limbs const &limbs)
+{
+  std::array<unsigned char, 8u * max_num_limbs> bytes{};
+  for (std::size_t i = 0u; i < bytes.size(); ++i) {
+    bytes[i] = limbs[i / 8u] >> (8u * (i % 8u));
+  }
+  IsMajsoulFair::Integer result;
+  result.importBits(bytes.data(), 8u * bytes.size(), IsMajsoulFair::BitOrder::least_significant_first);
+  return result;
+}
+
+IsMajsoulFair::Integer countPermutations(std::array<std::uint_fast8_t, 37u> const &num_tiles)
+{
+  if (num_tiles == IsMajsoulFair::FourPlayerTileSet::num_tiles_per_code) {
+    return importLimbs(num_permutations<IsMajsoulFair::FourPlayerTileSet>);
+  }
+  if (num_tiles == IsMajsoulFair::ThreePlayerTileSet::num_tiles_per_code) {
+    return importLimbs(num_permutations<IsMajsoulFair::ThreePlayerTileSet>);
+  }
+
+  IsMajsoulFair::Integer result(1ul);
+
+  unsigned long n = 0u;
+  for (std::uint_fast8_t const num : num_tiles) {
+    for (unsigned long c = 1u; c <= num; ++c) {
+      result *= ++n;
+      result /= c;
+    }
+  }
+  return result;
+}
+
+// A Fenwick tree of the number of tiles of each kind.
+class TileCountTree
+{
+public:
+  TileCountTree() noexcept
+    : tree_()
+  {}
+
+  void add(std::uint_fast8_t const tile, int const delta) noexcept
+  {
+    for (std::size_t i = tile + 1u; i <= tree_.size(); i += i & -i) {
+      tree_[i - 1u] += delta;
+    }
+  }
+
+  // Returns the number of tiles of the kinds less than `tile`.
+  unsigned long countLess(std::uint_fast8_t const tile) const noexcept
+  {
+    int result = 0;
+    for (std::size_t i = tile; i > 0u; i -= i & -i) {
+      result += tree_[i - 1u];
+    }
+    return result;
+  }
+
+  // Returns the kind of the `k`-th smallest tile, counting from zero. The
+  // descent is branch-free, since its direction is data-dependent.
+  std::uint_fast8_t find(unsigned long k) const noexcept
+  {
+    std::size_t position = 0u;
+    for (std::size_t step = tree_.size() / 2u; step > 0u; step >>= 1u) {
+      unsigned long const count = tree_[position + step - 1u];
+      bool const is_right = count <= k;
+      position += is_right ? step : 0u;
+      k -= is_right ? count : 0u;
+    }
+    return position;
+  }
+
+private:
+  std::array<int, 64u> tree_;
+}; // class TileCountTree
+
+} // namespace <unnamed>
+
+MultisetPermutationRanker::MultisetPermutationRanker()
+  : MultisetPermutationRanker(IsMajsoulFair::FourPlayerTileSet::num_tiles_per_code)
+{}
+
+MultisetPermutationRanker::MultisetPermutationRanker(std::array<std::uint_fast8_t, 37u> const &num_tiles)
+  : num_tiles_(num_tiles),
+    length_(0u),
+    num_permutations_(countPermutations(num_tiles))
+{
+  for (std::uint_fast8_t const num : num_tiles_) {
+    length_ += num;
+  }
+}
+
+std::size_t MultisetPermutationRanker::getLength() const noexcept
+{
+  return length_;
+}
+
+IsMajsoulFair::Integer const &MultisetPermutationRanker::getNumPermutations() const noexcept
+{
+  return num_permutations_;
+}
+
+IsMajsoulFair::Integer MultisetPermutationRanker::rank(std::vector<std::uint_fast8_t> const &permutation) const
+{
+  if (permutation.size() != length_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << permutation.size() << ": The length of `permutation` does not match that of the multiset.";
+  }
+
+  // The permutation is read backwards. Prepending a tile to a suffix of
+  // length `n - 1`, whose rank and number of distinct permutations are `r` and
+  // `m`, gives a suffix with the rank `r + p * m / c` and `m * n / c` distinct
+  // permutations, where `c` is the new number of tiles of the same kind and
+  // `p` is that of the tiles of smaller kinds. The suffix is kept as
+  // `rank + m * numerator / divisor` and `m * factor / divisor`, and
+  // `rank` and `m` are only updated when the machine words would overflow.
+  IsMajsoulFair::Integer rank(0ul);
+  IsMajsoulFair::Integer m(1ul);
+  IsMajsoulFair::Integer product;
+  rank.reserve(num_permutations_.bitLength() + 64u);
+  m.reserve(num_permutations_.bitLength() + 64u);
+  product.reserve(num_permutations_.bitLength() + 64u);
+  std::uint64_t numerator = 0u;
+  std::uint64_t factor = 1u;
+  std::uint64_t divisor = 1u;
+
+  TileCountTree suffix;
+  std::array<std::uint_fast8_t, 37u> suffix_num_tiles{};
+  for (std::size_t i = permutation.size(); i-- > 0u;) {
+    std::uint_fast8_t const tile = permutation[i];
+    if (tile >= suffix_num_tiles.size() || suffix_num_tiles[tile] == num_tiles_[tile]) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+        << static_cast<unsigned>(tile) << ": `permutation` is not a permutation of the multiset.";
+    }
+    std::uint64_t const c = ++suffix_num_tiles[tile];
+    std::uint64_t const n = permutation.size() - i;
+    std::uint64_t const p = suffix.countLess(tile);
+    suffix.add(tile, 1);
+
+    std::uint64_t new_numerator;
+    std::uint64_t new_factor;
+    std::uint64_t new_divisor;
+    std::uint64_t addend;
+    if (__builtin_mul_overflow(numerator, c, &new_numerator)
+        || __builtin_mul_overflow(p, factor, &addend)
+        || __builtin_add_overflow(new_numerator, addend, &new_numerator)
+        || __builtin_mul_overflow(factor, n, &new_factor)
+        || __builtin_mul_overflow(divisor, c, &new_divisor)) {
+      product = m;
+      product *= numerator;
+      product /= divisor;
+      rank += product;
+      m *= factor;
+      m /= divisor;
+      new_numerator = p;
+      new_factor = n;
+      new_divisor = c;
+    }
+    numerator = new_numerator;
+    factor = new_factor;
+    divisor = new_divisor;
+  }
+
+  product = m;
+  product *= numerator;
+  product /= divisor;
+  rank += product;
+
+  return rank;
+}
+
+std::vector<std::uint_fast8_t> MultisetPermutationRanker::unrank(IsMajsoulFair::Integer const &rank) const
+{
+  if (rank < 0l || rank >= num_permutations_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`rank` is out of range.");
+  }
+
+  TileCountTree remaining;
+  std::array<std::uint_fast8_t, 37u> remaining_num_tiles = num_tiles_;
+  for (std::uint_fast8_t tile = 0u; tile < remaining_num_tiles.size(); ++tile) {
+    remaining.add(tile, remaining_num_tiles[tile]);
+  }
+
+  // The permutations of the remaining `n` tiles that start with a tile of
+  // kind `t` occupy the ranks `[p * m / n, (p + c) * m / n)`, where `m` is the
+  // number of them all, and `p` and `c` are the numbers of the remaining
+  // tiles of kinds less than and equal to `t`, respectively. Only the ratio
+  // `x = r / m` of the rank within them matters, and it is mapped to
+  // `(x * n - p) / c`, so `r` and `m` are rescaled rather than divided.
+  //
+  // Several steps are taken on a 64-bit fixed-point enclosure of `x`, during
+  // which the exact `x` is kept as `(x0 * factor - numerator) / divisor` in
+  // machine words, until the enclosure can no longer tell `floor(x * n)` or
+  // the words would overflow. Only then are `r` and `m` updated.
+  IsMajsoulFair::Integer r = rank;
+  IsMajsoulFair::Integer m = num_permutations_;
+  IsMajsoulFair::Integer quotient;
+  {
+    std::size_t const num_bits = num_permutations_.bitLength() + 8u * length_ + 64u;
+    r.reserve(num_bits);
+    m.reserve(num_bits);
+    quotient.reserve(num_bits);
+  }
+  std::vector<std::uint_fast8_t> permutation;
+  permutation.reserve(length_);
+  auto const take = [&](std::uint_fast8_t const tile) {
+    remaining.add(tile, -1);
+    --remaining_num_tiles[tile];
+    permutation.push_back(tile);
+  };
+  for (unsigned long n = length_; n > 0u;) {
+    quotient = r;
+    quotient <<= 64u;
+    quotient /= m;
+    // `x` lies in `[lower, upper) / 2^64`.
+    unsigned __int128 lower = static_cast<unsigned long>(quotient);
+    unsigned __int128 upper = lower + 1u;
+
+    std::uint64_t factor = 1u;
+    std::uint64_t numerator = 0u;
+    std::uint64_t divisor = 1u;
+    for (; n > 0u && factor * static_cast<unsigned __int128>(n) < (std::uint64_t(1u) << 56u); --n) {
+      std::uint64_t const q = lower * n >> 64u;
+      if ((upper * n - 1u) >> 64u != q) {
+        break;
+      }
+      std::uint_fast8_t const tile = remaining.find(q);
+      std::uint64_t const p = remaining.countLess(tile);
+      std::uint64_t const c = remaining_num_tiles[tile];
+      lower = lower * n - (static_cast<unsigned __int128>(p) << 64u);
+      upper = upper * n - (static_cast<unsigned __int128>(p) << 64u) + (c - 1u);
+      switch (c) {
+      case 1u:
+        break;
+      case 2u:
+        lower >>= 1u;
+        upper >>= 1u;
+        break;
+      case 4u:
+        lower >>= 2u;
+        upper >>= 2u;
+        break;
+      default:
+        lower /= c;
+        upper /= c;
+        break;
+      }
+      factor *= n;
+      numerator = numerator * n + p * divisor;
+      divisor *= c;
+      take(tile);
+    }
+
+    if (factor != 1u) {
+      r *= factor;
+      r.submul(m, numerator);
+      m *= divisor;
+      continue;
+    }
+    if (n == 0u) {
+      break;
+    }
+
+    // The approximation cannot tell even the first step.
+    quotient = r;
+    quotient *= n;
+    quotient /= m;
+    std::uint_fast8_t const tile = remaining.find(static_cast<unsigned long>(quotient));
+    unsigned long const p = remaining.countLess(tile);
+    unsigned long const c = remaining_num_tiles[tile];
+    r *= n;
+    r.submul(m, p);
+    m *= c;
+    take(tile);
+    --n;
+  }
+
+  return permutation;
+}
+
+} // namespace IsMajsoulFair
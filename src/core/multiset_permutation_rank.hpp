@@ -0,0 +1,44 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_MULTISET_PERMUTATION_RANK_HPP)
+#define CORE_MULTISET_PERMUTATION_RANK_HPP
+
+#include "integer.hpp"
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// Maps the distinct permutations of a multiset of tiles, identical tiles being
+// indistinguishable, to their lexicographic ranks in `[0, M)` and back, where
+// `M` is the multinomial coefficient of the multiset.
+class MultisetPermutationRanker
+{
+public:
+  // Ranks full four-player walls.
+  MultisetPermutationRanker();
+
+  explicit MultisetPermutationRanker(std::array<std::uint_fast8_t, 37u> const &num_tiles);
+
+  std::size_t getLength() const noexcept;
+
+  IsMajsoulFair::Integer const &getNumPermutations() const noexcept;
+
+  IsMajsoulFair::Integer rank(std::vector<std::uint_fast8_t> const &permutation) const;
+
+  std::vector<std::uint_fast8_t> unrank(IsMajsoulFair::Integer const &rank) const;
+
+private:
+  std::array<std::uint_fast8_t, 37u> num_tiles_;
+  std::size_t length_;
+  IsMajsoulFair::Integer num_permutations_;
+}; // class MultisetPermutationRanker
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_MULTISET_PERMUTATION_RANK_HPP)
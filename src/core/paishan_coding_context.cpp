@@ -0,0 +1,14 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "paishan_coding_context.hpp"
+
+#include "integer.hpp"
+
+
+namespace IsMajsoulFair{
+
+template class BasicPaishanCodingContext<IsMajsoulFair::Integer>;
+
+} // namespace IsMajsoulFair
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_PAISHAN_CODING_CONTEXT_HPP)
+#define CORE_PAISHAN_CODING_CONTEXT_HPP
+
+#include "tile_set.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <numeric>
+#include <vector>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// The constants shared by every paishan of `length` tiles drawn from the
+// multiset `num_tiles` and extracted to `num_bits` bits: the denominator of
+// its interval, `N (N - 1) ... (N - length + 1)` for `N` tiles, and the
+// binary denominator `2^num_bits`. Built once and passed to the overloads of
+// `permutationToInterval`, `intervalToBinary` and `intervalToEntropy` that
+// take it, so that the work per paishan is only the data-dependent part.
+template<typename IntegerType>
+class BasicPaishanCodingContext
+{
+public:
+  using integer_type = IntegerType;
+
+  BasicPaishanCodingContext(
+    std::array<std::uint_fast8_t, 37u> const &num_tiles, std::size_t length, std::size_t num_bits);
+
+  template<IsMajsoulFair::TileSetPolicy TileSet>
+  BasicPaishanCodingContext(TileSet, std::size_t length, std::size_t num_bits);
+
+  std::array<std::uint_fast8_t, 37u> const &getNumTiles() const noexcept;
+
+  std::size_t getLength() const noexcept;
+
+  std::size_t getNumBits() const noexcept;
+
+  IntegerType const &getDenominator() const noexcept;
+
+  IntegerType const &getBinaryDenominator() const noexcept;
+
+  // The factor by which step `i` of a paishan scales the denominator,
+  // `N - i`.
+  unsigned long getDenominatorFactor(std::size_t i) const;
+
+private:
+  std::array<std::uint_fast8_t, 37u> num_tiles_;
+  std::size_t length_;
+  std::size_t num_bits_;
+  std::size_t total_num_tiles_;
+  IntegerType denominator_;
+  IntegerType binary_denominator_;
+}; // class BasicPaishanCodingContext
+
+using PaishanCodingContext = BasicPaishanCodingContext<IsMajsoulFair::Integer>;
+
+template<typename IntegerType>
+BasicPaishanCodingContext<IntegerType>::BasicPaishanCodingContext(
+  std::array<std::uint_fast8_t, 37u> const &num_tiles, std::size_t const length, std::size_t const num_bits)
+  : num_tiles_(num_tiles),
+    length_(length),
+    num_bits_(num_bits),
+    total_num_tiles_(std::accumulate(num_tiles.cbegin(), num_tiles.cend(), std::size_t(0u))),
+    denominator_(1ul),
+    binary_denominator_(IntegerType(1ul) << num_bits)
+{
+  using std::placeholders::_1;
+
+  if (length_ > total_num_tiles_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << length_ << ": The length must not exceed the number of tiles, " << total_num_tiles_ << '.';
+  }
+
+  for (std::size_t i = 0u; i < length_; ++i) {
+    denominator_ *= static_cast<unsigned long>(total_num_tiles_ - i);
+  }
+}
+
+template<typename IntegerType>
+template<IsMajsoulFair::TileSetPolicy TileSet>
+BasicPaishanCodingContext<IntegerType>::BasicPaishanCodingContext(
+  TileSet, std::size_t const length, std::size_t const num_bits)
+  : BasicPaishanCodingContext(TileSet::num_tiles_per_code, length, num_bits)
+{}
+
+template<typename IntegerType>
+std::array<std::uint_fast8_t, 37u> const &BasicPaishanCodingContext<IntegerType>::getNumTiles() const noexcept
+{
+  return num_tiles_;
+}
+
+template<typename IntegerType>
+std::size_t BasicPaishanCodingContext<IntegerType>::getLength() const noexcept
+{
+  return length_;
+}
+
+template<typename IntegerType>
+std::size_t BasicPaishanCodingContext<IntegerType>::getNumBits() const noexcept
+{
+  return num_bits_;
+}
+
+template<typename IntegerType>
+IntegerType const &BasicPaishanCodingContext<IntegerType>::getDenominator() const noexcept
+{
+  return denominator_;
+}
+
+template<typename IntegerType>
+IntegerType const &BasicPaishanCodingContext<IntegerType>::getBinaryDenominator() const noexcept
+{
+  return binary_denominator_;
+}
+
+template<typename IntegerType>
+unsigned long BasicPaishanCodingContext<IntegerType>::getDenominatorFactor(std::size_t const i) const
+{
+  if (i >= length_) {
+    IS_MAJSOUL_FAIR_THROW<std::out_of_range>("`i` is out of range.");
+  }
+  return total_num_tiles_ - i;
+}
+
+extern template class BasicPaishanCodingContext<IsMajsoulFair::Integer>;
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_PAISHAN_CODING_CONTEXT_HPP)
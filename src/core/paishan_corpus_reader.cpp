@@ -0,0 +1,120 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "paishan_corpus_reader.hpp"
+
+#include "binary_paishan_corpus.hpp"
+#include "memory_mapped_file.hpp"
+#include "../common/throw.hpp"
+#include <filesystem>
+#include <span>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+} // namespace <unnamed>
+
+namespace IsMajsoulFair{
+
+std::size_t parsePaishanLine(
+  char const *&p,
+  char const * const last,
+  std::span<std::uint8_t> const row,
+  std::filesystem::path const &path,
+  std::size_t const offset)
+{
+  // Every tile is one or two digits followed by a comma, a newline or the
+  // end of the file. The digits are read unconditionally and validated
+  // together, so that the only data-dependent branch is on the width.
+  std::size_t length = 0u;
+  while (true) {
+    unsigned const d0 = static_cast<unsigned char>(*p) - '0';
+    unsigned const d1 = p + 1 != last ? static_cast<unsigned char>(p[1]) - '0' : 10u;
+    bool const two_digits = d1 < 10u;
+    unsigned const tile = two_digits ? d0 * 10u + d1 : d0;
+    p += two_digits ? 2 : 1;
+    if (d0 >= 10u || tile >= 37u || (p != last && *p != ',' && *p != '\n')) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ':' << offset << ": An invalid tile.";
+    }
+    if (length == row.size()) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ':' << offset << ": Too many tiles.";
+    }
+    row[length++] = static_cast<std::uint8_t>(tile);
+
+    if (p == last || *p == '\n') {
+      break;
+    }
+    ++p;
+    if (p == last || *p == '\n') {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ':' << offset << ": A trailing comma.";
+    }
+  }
+
+  return length;
+}
+
+PaishanCorpusReader::PaishanCorpusReader(std::filesystem::path const &path)
+  : file_(path),
+    first_(file_.getBytes().data()),
+    last_(first_ + file_.getBytes().size()),
+    position_(first_),
+    binary_(IsMajsoulFair::isBinaryPaishanCorpus(file_.getBytes())),
+    header_(),
+    buffer_()
+{
+  if (binary_) {
+    header_ = IsMajsoulFair::readBinaryPaishanCorpusHeader(file_.getBytes());
+    position_ += IsMajsoulFair::binary_paishan_corpus_header_size;
+  }
+}
+
+std::size_t PaishanCorpusReader::getOffset() const noexcept
+{
+  return position_ - first_;
+}
+
+std::size_t PaishanCorpusReader::read(std::span<std::uint8_t> const row)
+{
+  if (binary_) {
+    return readBinary_(row);
+  }
+
+  char const *p = position_;
+  while (p != last_ && *p == '\n') {
+    ++p;
+  }
+  if (p == last_) {
+    position_ = p;
+    return 0u;
+  }
+
+  std::size_t const length = IsMajsoulFair::parsePaishanLine(
+    p, last_, row, file_.getPath(), static_cast<std::size_t>(position_ - first_));
+  position_ = p;
+  return length;
+}
+
+std::size_t PaishanCorpusReader::readBinary_(std::span<std::uint8_t> const row)
+{
+  if (position_ == last_) {
+    return 0u;
+  }
+  IsMajsoulFair::decodeBinaryPaishanRecord(header_, position_, row);
+  position_ += header_.getRecordSize();
+  return header_.length;
+}
+
+std::span<std::uint8_t const> PaishanCorpusReader::next()
+{
+  std::size_t const length = read(buffer_);
+  return std::span<std::uint8_t const>(buffer_.data(), length);
+}
+
+} // namespace IsMajsoulFair
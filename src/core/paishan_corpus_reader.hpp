@@ -0,0 +1,75 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_PAISHAN_CORPUS_READER_HPP)
+#define CORE_PAISHAN_CORPUS_READER_HPP
+
+#include "binary_paishan_corpus.hpp"
+#include "memory_mapped_file.hpp"
+#include <filesystem>
+#include <span>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// Parses the comma-separated tile codes of the nonempty line at `p` of a text
+// ending at `last` into `row`, advances `p` to the newline or `last` that ends
+// the line, and returns the number of the tiles. `path` and `offset` only
+// locate the line in error messages.
+std::size_t parsePaishanLine(
+  char const *&p,
+  char const *last,
+  std::span<std::uint8_t> row,
+  std::filesystem::path const &path,
+  std::size_t offset);
+
+// Reads a corpus of paishan, one per line as comma-separated tile codes,
+// directly out of a read-only memory mapping of the file. Every paishan is
+// parsed into a fixed-size buffer, so no line is copied and nothing is
+// allocated per paishan. Empty lines are skipped.
+//
+// A binary corpus, as written by `BinaryPaishanCorpusWriter`, is recognized by
+// its magic and read record by record instead, so that every tool reading
+// through this class accepts either form.
+class PaishanCorpusReader
+{
+public:
+  // The longest paishan a line may hold.
+  static constexpr std::size_t max_length = 256u;
+
+  explicit PaishanCorpusReader(std::filesystem::path const &path);
+
+  PaishanCorpusReader(PaishanCorpusReader const &) = delete;
+
+  PaishanCorpusReader &operator=(PaishanCorpusReader const &) = delete;
+
+  // The byte offset of the next line, or the next record, in the file.
+  std::size_t getOffset() const noexcept;
+
+  // Parses the next paishan into `row`, and returns the number of its tiles,
+  // or `0` at the end of the file.
+  std::size_t read(std::span<std::uint8_t> row);
+
+  // Parses the next paishan, and returns a view of it, which stays valid until
+  // the next call, or an empty view at the end of the file.
+  std::span<std::uint8_t const> next();
+
+private:
+  std::size_t readBinary_(std::span<std::uint8_t> row);
+
+  IsMajsoulFair::MemoryMappedFile file_;
+  char const *first_;
+  char const *last_;
+  char const *position_;
+  bool binary_;
+  IsMajsoulFair::BinaryPaishanCorpusHeader header_;
+  std::array<std::uint8_t, max_length> buffer_;
+}; // class PaishanCorpusReader
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_PAISHAN_CORPUS_READER_HPP)
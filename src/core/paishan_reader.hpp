@@ -1,8 +1,14 @@
 #if !defined(CORE_PAISHAN_READER_HPP_INCLUDE_GUARD)
 #define CORE_PAISHAN_READER_HPP_INCLUDE_GUARD
 
+#include "tile_set.hpp"
+#include "../common/throw.hpp"
 #include <iosfwd>
+#include <span>
 #include <vector>
+#include <array>
+#include <functional>
+#include <stdexcept>
 #include <cstdint>
 
 
@@ -10,6 +16,30 @@ namespace IsMajsoulFair{
 
 std::vector<std::uint_fast8_t> readPaishan(std::uint_fast8_t const num_tiles, std::istream &is);
 
+// Checks that `paishan`, e.g., a view from `PaishanCorpusReader`, is a full or
+// a partial wall of the tile set `TileSet`, i.e., that it is of either length
+// and a prefix of such a wall.
+template<typename TileSet, typename Tile>
+void checkPaishan(std::span<Tile const> const paishan)
+{
+  using std::placeholders::_1;
+
+  if (paishan.size() != TileSet::num_partial_tiles && paishan.size() != TileSet::num_tiles) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << paishan.size() << ": The number of tiles must be " << TileSet::num_partial_tiles
+      << " or " << TileSet::num_tiles << '.';
+  }
+
+  std::array<std::uint_fast8_t, 37u> num_remaining_tiles = TileSet::num_tiles_per_code;
+  for (Tile const tile : paishan) {
+    if (tile >= num_remaining_tiles.size() || num_remaining_tiles[tile] == 0u) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1)
+        << static_cast<unsigned>(tile) << ": The tile is not in the tile set, or appears too many times.";
+    }
+    --num_remaining_tiles[tile];
+  }
+}
+
 } // namespace IsMajsoulFair
 
 #endif // !defined(CORE_PAISHAN_READER_HPP_INCLUDE_GUARD)
@@ -0,0 +1,207 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "parallel_paishan_corpus_reader.hpp"
+
+#include "paishan_corpus_reader.hpp"
+#include "binary_paishan_corpus.hpp"
+#include "memory_mapped_file.hpp"
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include <array>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+std::size_t PaishanChunk::getNumPaishan() const noexcept
+{
+  return ends.size();
+}
+
+std::span<std::uint8_t const> PaishanChunk::getPaishan(std::size_t const i) const noexcept
+{
+  std::size_t const first = i == 0u ? 0u : ends[i - 1u];
+  return std::span<std::uint8_t const>(tiles.data() + first, ends[i] - first);
+}
+
+ParallelPaishanCorpusReader::ParallelPaishanCorpusReader(
+  std::filesystem::path const &path,
+  std::size_t const num_threads,
+  IsMajsoulFair::PaishanChunkOrder const order,
+  std::size_t const chunk_size)
+  : file_(path),
+    binary_(IsMajsoulFair::isBinaryPaishanCorpus(file_.getBytes())),
+    header_(),
+    order_(order),
+    bounds_(),
+    window_(),
+    mutex_(),
+    worker_condition_(),
+    consumer_condition_(),
+    stopped_(false),
+    num_started_(0u),
+    num_consumed_(0u),
+    parsed_(),
+    pool_(),
+    threads_()
+{
+  std::span<char const> const bytes = file_.getBytes();
+  if (binary_) {
+    header_ = IsMajsoulFair::readBinaryPaishanCorpusHeader(bytes);
+    std::size_t const record_size = header_.getRecordSize();
+    std::size_t const stride = std::max<std::size_t>(chunk_size / record_size, 1u) * record_size;
+    for (std::size_t offset = IsMajsoulFair::binary_paishan_corpus_header_size; offset < bytes.size();
+         offset += stride) {
+      bounds_.push_back(offset);
+    }
+  }
+  else {
+    // Every chunk but the last ends just after a newline, so that no line is
+    // split across chunks.
+    for (std::size_t offset = 0u; offset < bytes.size();) {
+      bounds_.push_back(offset);
+      offset += std::max<std::size_t>(chunk_size, 1u);
+      if (offset >= bytes.size()) {
+        break;
+      }
+      void const * const newline = std::memchr(bytes.data() + offset, '\n', bytes.size() - offset);
+      offset = newline == nullptr ? bytes.size() : static_cast<char const *>(newline) - bytes.data() + 1u;
+    }
+  }
+  bounds_.push_back(bytes.size());
+
+  std::size_t const n = num_threads == 0u ? std::max(std::thread::hardware_concurrency(), 1u) : num_threads;
+  window_ = 2u * n;
+  threads_.reserve(n);
+  for (std::size_t i = 0u; i < n; ++i) {
+    threads_.emplace_back(&ParallelPaishanCorpusReader::work_, this);
+  }
+}
+
+ParallelPaishanCorpusReader::~ParallelPaishanCorpusReader()
+{
+  {
+    std::scoped_lock lock(mutex_);
+    stopped_ = true;
+  }
+  worker_condition_.notify_all();
+  threads_.clear();
+}
+
+std::size_t ParallelPaishanCorpusReader::getNumThreads() const noexcept
+{
+  return threads_.size();
+}
+
+std::size_t ParallelPaishanCorpusReader::getNumChunks() const noexcept
+{
+  return bounds_.size() - 1u;
+}
+
+bool ParallelPaishanCorpusReader::next(IsMajsoulFair::PaishanChunk &chunk)
+{
+  std::unique_lock lock(mutex_);
+  if (num_consumed_ == getNumChunks()) {
+    return false;
+  }
+  consumer_condition_.wait(lock, [this]() {
+    return !parsed_.empty()
+      && (order_ == IsMajsoulFair::PaishanChunkOrder::unordered || parsed_.begin()->first == num_consumed_);
+  });
+  auto node = parsed_.extract(parsed_.begin());
+  ++num_consumed_;
+  pool_.push_back(std::move(chunk));
+  lock.unlock();
+  worker_condition_.notify_one();
+
+  if (node.mapped().error) {
+    std::rethrow_exception(node.mapped().error);
+  }
+  chunk = std::move(node.mapped().chunk);
+  return true;
+}
+
+void ParallelPaishanCorpusReader::parse_(std::size_t const index, IsMajsoulFair::PaishanChunk &chunk) const
+{
+  char const * const data = file_.getBytes().data();
+  char const *p = data + bounds_[index];
+  char const * const last = data + bounds_[index + 1u];
+
+  if (binary_) {
+    std::size_t const record_size = header_.getRecordSize();
+    for (; p != last; p += record_size) {
+      std::size_t const size = chunk.tiles.size();
+      chunk.tiles.resize(size + header_.length);
+      IsMajsoulFair::decodeBinaryPaishanRecord(
+        header_, p, std::span<std::uint8_t>(chunk.tiles.data() + size, header_.length));
+      chunk.ends.push_back(chunk.tiles.size());
+    }
+    return;
+  }
+
+  std::array<std::uint8_t, IsMajsoulFair::PaishanCorpusReader::max_length> row;
+  while (true) {
+    while (p != last && *p == '\n') {
+      ++p;
+    }
+    if (p == last) {
+      break;
+    }
+    std::size_t const length
+      = IsMajsoulFair::parsePaishanLine(p, last, row, file_.getPath(), static_cast<std::size_t>(p - data));
+    chunk.tiles.insert(chunk.tiles.end(), row.cbegin(), row.cbegin() + length);
+    chunk.ends.push_back(chunk.tiles.size());
+  }
+}
+
+void ParallelPaishanCorpusReader::work_()
+{
+  while (true) {
+    std::size_t index;
+    IsMajsoulFair::PaishanChunk chunk;
+    {
+      std::unique_lock lock(mutex_);
+      worker_condition_.wait(lock, [this]() {
+        return stopped_ || num_started_ == getNumChunks() || num_started_ - num_consumed_ < window_;
+      });
+      if (stopped_ || num_started_ == getNumChunks()) {
+        return;
+      }
+      index = num_started_++;
+      if (!pool_.empty()) {
+        chunk = std::move(pool_.back());
+        pool_.pop_back();
+      }
+    }
+
+    chunk.index = index;
+    chunk.tiles.clear();
+    chunk.ends.clear();
+    Slot slot;
+    try {
+      parse_(index, chunk);
+    }
+    catch (...) {
+      slot.error = std::current_exception();
+    }
+    slot.chunk = std::move(chunk);
+
+    {
+      std::scoped_lock lock(mutex_);
+      parsed_.emplace(index, std::move(slot));
+    }
+    consumer_condition_.notify_one();
+  }
+}
+
+} // namespace IsMajsoulFair
@@ -0,0 +1,114 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_PARALLEL_PAISHAN_CORPUS_READER_HPP)
+#define CORE_PARALLEL_PAISHAN_CORPUS_READER_HPP
+
+#include "binary_paishan_corpus.hpp"
+#include "memory_mapped_file.hpp"
+#include <condition_variable>
+#include <exception>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// The paishan parsed out of a chunk of a corpus, stored back to back.
+struct PaishanChunk
+{
+  // The position of the chunk in the corpus, counting from zero.
+  std::size_t index;
+  std::vector<std::uint8_t> tiles;
+  // The end of every paishan in `tiles`.
+  std::vector<std::size_t> ends;
+
+  std::size_t getNumPaishan() const noexcept;
+
+  std::span<std::uint8_t const> getPaishan(std::size_t i) const noexcept;
+}; // struct PaishanChunk
+
+enum class PaishanChunkOrder
+{
+  // Chunks are handed out in the order of the corpus.
+  ordered,
+  // Chunks are handed out as soon as they are parsed.
+  unordered
+}; // enum class PaishanChunkOrder
+
+// Reads a corpus that `PaishanCorpusReader` accepts on worker threads. The
+// memory mapping is split into chunks of about `chunk_size` bytes, text ones
+// at newlines and binary ones at records, and the workers parse whole chunks
+// into `PaishanChunk`s, which `next` hands to the consumer. At most
+// `2 * num_threads` chunks are parsed ahead of the consumer, so memory stays
+// bounded however slow the consumer is. An error in a chunk is rethrown by
+// `next` where the chunk would have been handed out.
+class ParallelPaishanCorpusReader
+{
+public:
+  static constexpr std::size_t default_chunk_size = std::size_t(1u) << 22u;
+
+  // `num_threads == 0` means `std::thread::hardware_concurrency()`.
+  ParallelPaishanCorpusReader(
+    std::filesystem::path const &path,
+    std::size_t num_threads,
+    IsMajsoulFair::PaishanChunkOrder order = IsMajsoulFair::PaishanChunkOrder::ordered,
+    std::size_t chunk_size = default_chunk_size);
+
+  ParallelPaishanCorpusReader(ParallelPaishanCorpusReader const &) = delete;
+
+  ParallelPaishanCorpusReader &operator=(ParallelPaishanCorpusReader const &) = delete;
+
+  ~ParallelPaishanCorpusReader();
+
+  std::size_t getNumThreads() const noexcept;
+
+  std::size_t getNumChunks() const noexcept;
+
+  // Moves the next chunk into `chunk`, and returns `false` at the end of the
+  // corpus. The buffers that `chunk` held are recycled for later chunks.
+  bool next(IsMajsoulFair::PaishanChunk &chunk);
+
+private:
+  struct Slot
+  {
+    IsMajsoulFair::PaishanChunk chunk;
+    std::exception_ptr error;
+  }; // struct Slot
+
+  void parse_(std::size_t index, IsMajsoulFair::PaishanChunk &chunk) const;
+
+  void work_();
+
+  IsMajsoulFair::MemoryMappedFile file_;
+  bool binary_;
+  IsMajsoulFair::BinaryPaishanCorpusHeader header_;
+  IsMajsoulFair::PaishanChunkOrder order_;
+  // Chunk `i` is `[bounds_[i], bounds_[i + 1])` of the mapping.
+  std::vector<std::size_t> bounds_;
+  std::size_t window_;
+
+  std::mutex mutex_;
+  std::condition_variable worker_condition_;
+  std::condition_variable consumer_condition_;
+  bool stopped_;
+  std::size_t num_started_;
+  std::size_t num_consumed_;
+  std::map<std::size_t, Slot> parsed_;
+  std::vector<IsMajsoulFair::PaishanChunk> pool_;
+
+  // Declared last so that the workers are joined before anything they touch
+  // is destroyed.
+  std::vector<std::jthread> threads_;
+}; // class ParallelPaishanCorpusReader
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_PARALLEL_PAISHAN_CORPUS_READER_HPP)
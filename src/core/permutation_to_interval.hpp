@@ -5,14 +5,318 @@
 #if !defined(CORE_PERMUTATION_TO_INTERVAL_HPP)
 #define CORE_PERMUTATION_TO_INTERVAL_HPP
 
+#include "paishan_coding_context.hpp"
+#include "tile_set.hpp"
 #include "interval.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <sstream>
+#include <thread>
+#include <numeric>
 #include <vector>
+#include <array>
+#include <functional>
+#include <bit>
+#include <stdexcept>
 #include <cstdint>
+#include <cstddef>
 
 
 namespace IsMajsoulFair{
 
-IsMajsoulFair::Interval permutationToInterval(std::vector<std::uint_fast8_t> const &permutation);
+// Maps a permutation of a multiset of tiles, `num_tiles[t]` being the number
+// of tiles of kind `t`, to the subinterval of `[0, 1)` that it occupies when
+// the distinct permutations of the multiset are laid out in lexicographic
+// order with equal widths. `permutation` may be a prefix of one.
+template<typename IntegerType = IsMajsoulFair::Integer>
+IsMajsoulFair::BasicInterval<IntegerType> permutationToInterval(
+  std::vector<std::uint_fast8_t> const &permutation,
+  std::array<std::uint_fast8_t, 37u> num_tiles)
+{
+  using std::placeholders::_1;
+
+  std::size_t const total_num_tiles = std::accumulate(num_tiles.cbegin(), num_tiles.cend(), std::size_t(0u));
+
+  IntegerType denominator(1ul);
+  IntegerType lower_numerator(0ul);
+  IntegerType difference(1ul);
+  {
+    // Each factor of the denominator is at most `total_num_tiles`.
+    std::size_t const num_bits = std::bit_width(total_num_tiles) * permutation.size();
+    denominator.reserve(num_bits);
+    lower_numerator.reserve(num_bits);
+    difference.reserve(num_bits);
+  }
+
+  {
+    unsigned long denominator_factor = total_num_tiles;
+    for (std::size_t i = 0u; i < permutation.size(); ++i, --denominator_factor) {
+      std::uint_fast8_t const tile = permutation[i];
+      if (tile >= num_tiles.size()) {
+        IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("An invalid `permutation` was passed.");
+      }
+      if (num_tiles[tile] == 0u) {
+        std::ostringstream oss;
+        {
+          bool is_first = true;
+          for (std::uint_fast8_t t : permutation) {
+            if (!is_first) {
+              oss << ", ";
+            }
+            oss << static_cast<unsigned>(t);
+            is_first = false;
+          }
+        }
+        IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << "An invalid `permutation` was passed: " << oss.str();
+      }
+      unsigned long offset = std::accumulate(num_tiles.begin(), num_tiles.begin() + tile, 0ul);
+
+      // `difference` is `upper_numerator - lower_numerator`, so the new upper
+      // numerator is never formed until the end.
+      lower_numerator *= denominator_factor;
+      lower_numerator.addmul(difference, offset);
+      difference *= static_cast<unsigned long>(num_tiles[tile]);
+      denominator *= denominator_factor;
+
+      --num_tiles[tile];
+    }
+  }
+
+  IntegerType upper_numerator = lower_numerator;
+  upper_numerator += difference;
+
+  return {denominator, lower_numerator, upper_numerator};
+}
+
+// Specialized on a tile set, e.g., `permutationToInterval(p, ThreePlayerTileSet())`.
+template<typename IntegerType = IsMajsoulFair::Integer, IsMajsoulFair::TileSetPolicy TileSet>
+IsMajsoulFair::BasicInterval<IntegerType> permutationToInterval(
+  std::vector<std::uint_fast8_t> const &permutation, TileSet)
+{
+  return IsMajsoulFair::permutationToInterval<IntegerType>(permutation, TileSet::num_tiles_per_code);
+}
+
+template<typename IntegerType = IsMajsoulFair::Integer>
+IsMajsoulFair::BasicInterval<IntegerType> permutationToInterval(std::vector<std::uint_fast8_t> const &permutation)
+{
+  return IsMajsoulFair::permutationToInterval<IntegerType>(permutation, IsMajsoulFair::FourPlayerTileSet());
+}
+
+// The same as above for a paishan of `context.getLength()` tiles drawn from
+// `context.getNumTiles()`, but the denominator is taken from `context`, and
+// the interval is written to `result`, reusing its storage. Consecutive steps
+// are composed in machine words while they fit, so that the integers are
+// touched only once per several tiles.
+template<typename IntegerType>
+void permutationToInterval(
+  std::vector<std::uint_fast8_t> const &permutation,
+  IsMajsoulFair::BasicPaishanCodingContext<IntegerType> const &context,
+  IsMajsoulFair::BasicInterval<IntegerType> &result)
+{
+  using std::placeholders::_1;
+
+  if (permutation.size() != context.getLength()) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << permutation.size() << ": The length must be " << context.getLength() << '.';
+  }
+
+  std::array<std::uint_fast8_t, 37u> num_tiles = context.getNumTiles();
+  IntegerType lower_numerator(0ul);
+  IntegerType difference(1ul);
+  std::uint64_t factor = 1u;
+  std::uint64_t offset = 0u;
+  std::uint64_t count = 1u;
+  auto const flush = [&]() {
+    lower_numerator *= static_cast<unsigned long>(factor);
+    lower_numerator.addmul(difference, static_cast<unsigned long>(offset));
+    difference *= static_cast<unsigned long>(count);
+  };
+  for (std::size_t i = 0u; i < permutation.size(); ++i) {
+    std::uint_fast8_t const tile = permutation[i];
+    if (tile >= num_tiles.size() || num_tiles[tile] == 0u) {
+      // Lets the version without a context report the error in its own words.
+      IsMajsoulFair::permutationToInterval<IntegerType>(permutation, context.getNumTiles());
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    }
+    std::uint64_t const step_factor = context.getDenominatorFactor(i);
+    std::uint64_t const step_offset = std::accumulate(num_tiles.cbegin(), num_tiles.cbegin() + tile, 0ul);
+    std::uint64_t const step_count = num_tiles[tile];
+
+    // `(factor, offset, count)` followed by the step is
+    // `(factor * f, offset * f + count * o, count * c)`.
+    std::uint64_t new_factor;
+    std::uint64_t new_offset;
+    std::uint64_t new_count;
+    std::uint64_t addend;
+    if (__builtin_mul_overflow(factor, step_factor, &new_factor)
+        || __builtin_mul_overflow(offset, step_factor, &new_offset)
+        || __builtin_mul_overflow(count, step_offset, &addend)
+        || __builtin_add_overflow(new_offset, addend, &new_offset)
+        || __builtin_mul_overflow(count, step_count, &new_count)) {
+      flush();
+      new_factor = step_factor;
+      new_offset = step_offset;
+      new_count = step_count;
+    }
+    factor = new_factor;
+    offset = new_offset;
+    count = new_count;
+
+    --num_tiles[tile];
+  }
+  flush();
+
+  difference += lower_numerator;
+  result.assign(context.getDenominator(), lower_numerator, difference);
+}
+
+namespace Detail_{
+
+// Each step of `permutationToInterval` maps `(denominator, lower_numerator,
+// difference)` to `(denominator * d, lower_numerator * d + difference * o,
+// difference * c)`. The composition of consecutive steps is of the same form,
+// and is represented by the image of `(1, 0, 1)`.
+template<typename IntegerType>
+struct IntervalStep
+{
+  IntegerType denominator;
+  IntegerType lower_numerator;
+  IntegerType difference;
+}; // struct IntervalStep
+
+// Subtrees with fewer steps are not worth a thread of their own.
+inline constexpr std::size_t min_num_interval_steps_per_thread = 32u;
+
+// Composes `steps[first, last)` into `steps[first]`.
+template<typename IntegerType>
+void composeIntervalSteps(
+  std::vector<Detail_::IntervalStep<IntegerType>> &steps,
+  std::size_t const first,
+  std::size_t const last,
+  std::size_t const num_threads)
+{
+  if (last - first <= 1u) {
+    return;
+  }
+
+  std::size_t const middle = first + (last - first) / 2u;
+  if (num_threads >= 2u && last - first >= 2u * Detail_::min_num_interval_steps_per_thread) {
+    std::jthread thread(
+      &Detail_::composeIntervalSteps<IntegerType>, std::ref(steps), first, middle, num_threads / 2u);
+    Detail_::composeIntervalSteps(steps, middle, last, num_threads - num_threads / 2u);
+    thread.join();
+  }
+  else {
+    Detail_::composeIntervalSteps(steps, first, middle, 1u);
+    Detail_::composeIntervalSteps(steps, middle, last, 1u);
+  }
+
+  Detail_::IntervalStep<IntegerType> &earlier = steps[first];
+  Detail_::IntervalStep<IntegerType> const &later = steps[middle];
+  earlier.lower_numerator *= later.denominator;
+  earlier.lower_numerator.addmul(later.lower_numerator, earlier.difference);
+  earlier.difference *= later.difference;
+  earlier.denominator *= later.denominator;
+}
+
+} // namespace Detail_
+
+// The same as `permutationToInterval`, but composes the steps pairwise in a
+// balanced binary tree, so that large multiplications are between operands of
+// similar sizes, and the halves of the tree are composed on up to
+// `num_threads` threads.
+template<typename IntegerType = IsMajsoulFair::Integer>
+IsMajsoulFair::BasicInterval<IntegerType> permutationToIntervalByProductTree(
+  std::vector<std::uint_fast8_t> const &permutation,
+  std::array<std::uint_fast8_t, 37u> num_tiles,
+  std::size_t const num_threads = 1u)
+{
+  std::vector<Detail_::IntervalStep<IntegerType>> steps;
+  {
+    std::array<std::uint_fast8_t, 37u> const initial_num_tiles = num_tiles;
+    unsigned long denominator_factor = std::accumulate(num_tiles.cbegin(), num_tiles.cend(), 0ul);
+    // Consecutive steps are composed in machine words while they fit.
+    std::uint64_t denominator = 1u;
+    std::uint64_t lower_numerator = 0u;
+    std::uint64_t difference = 1u;
+    for (std::size_t i = 0u; i < permutation.size(); ++i, --denominator_factor) {
+      std::uint_fast8_t const tile = permutation[i];
+      if (tile >= num_tiles.size() || num_tiles[tile] == 0u) {
+        // Lets the sequential version report the error in its own words.
+        IsMajsoulFair::permutationToInterval<IntegerType>(permutation, initial_num_tiles);
+        IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+      }
+      std::uint64_t const offset = std::accumulate(num_tiles.cbegin(), num_tiles.cbegin() + tile, 0ul);
+      std::uint64_t const count = num_tiles[tile];
+
+      std::uint64_t new_denominator;
+      std::uint64_t new_lower_numerator;
+      std::uint64_t new_difference;
+      std::uint64_t addend;
+      if (__builtin_mul_overflow(denominator, denominator_factor, &new_denominator)
+          || __builtin_mul_overflow(lower_numerator, denominator_factor, &new_lower_numerator)
+          || __builtin_mul_overflow(difference, offset, &addend)
+          || __builtin_add_overflow(new_lower_numerator, addend, &new_lower_numerator)
+          || __builtin_mul_overflow(difference, count, &new_difference)) {
+        steps.push_back({IntegerType(denominator), IntegerType(lower_numerator), IntegerType(difference)});
+        new_denominator = denominator_factor;
+        new_lower_numerator = offset;
+        new_difference = count;
+      }
+      denominator = new_denominator;
+      lower_numerator = new_lower_numerator;
+      difference = new_difference;
+
+      --num_tiles[tile];
+    }
+    steps.push_back({IntegerType(denominator), IntegerType(lower_numerator), IntegerType(difference)});
+  }
+
+  Detail_::composeIntervalSteps(steps, 0u, steps.size(), num_threads == 0u ? 1u : num_threads);
+
+  Detail_::IntervalStep<IntegerType> &result = steps.front();
+  IntegerType upper_numerator = result.lower_numerator;
+  upper_numerator += result.difference;
+
+  return {result.denominator, result.lower_numerator, upper_numerator};
+}
+
+template<typename IntegerType = IsMajsoulFair::Integer, IsMajsoulFair::TileSetPolicy TileSet>
+IsMajsoulFair::BasicInterval<IntegerType> permutationToIntervalByProductTree(
+  std::vector<std::uint_fast8_t> const &permutation,
+  TileSet,
+  std::size_t const num_threads = 1u)
+{
+  return IsMajsoulFair::permutationToIntervalByProductTree<IntegerType>(
+    permutation, TileSet::num_tiles_per_code, num_threads);
+}
+
+template<typename IntegerType = IsMajsoulFair::Integer>
+IsMajsoulFair::BasicInterval<IntegerType> permutationToIntervalByProductTree(
+  std::vector<std::uint_fast8_t> const &permutation,
+  std::size_t const num_threads = 1u)
+{
+  return IsMajsoulFair::permutationToIntervalByProductTree<IntegerType>(
+    permutation, IsMajsoulFair::FourPlayerTileSet(), num_threads);
+}
+
+extern template IsMajsoulFair::Interval permutationToInterval(
+  std::vector<std::uint_fast8_t> const &permutation, std::array<std::uint_fast8_t, 37u> num_tiles);
+
+extern template IsMajsoulFair::Interval permutationToInterval(std::vector<std::uint_fast8_t> const &permutation);
+
+extern template void permutationToInterval(
+  std::vector<std::uint_fast8_t> const &permutation,
+  IsMajsoulFair::PaishanCodingContext const &context,
+  IsMajsoulFair::Interval &result);
+
+extern template IsMajsoulFair::Interval permutationToIntervalByProductTree(
+  std::vector<std::uint_fast8_t> const &permutation,
+  std::array<std::uint_fast8_t, 37u> num_tiles,
+  std::size_t num_threads);
+
+extern template IsMajsoulFair::Interval permutationToIntervalByProductTree(
+  std::vector<std::uint_fast8_t> const &permutation, std::size_t num_threads);
 
 } // namespace IsMajsoulFair
 
@@ -0,0 +1,331 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "permutation_to_interval_batch.hpp"
+
+#include "permutation_to_interval.hpp"
+#include "tile_set.hpp"
+#include "interval.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <algorithm>
+#include <numeric>
+#include <span>
+#include <vector>
+#include <array>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif // defined(__x86_64__)
+
+
+namespace IsMajsoulFair{
+
+namespace{
+
+constexpr std::size_t num_lanes = 8u;
+
+constexpr std::size_t max_length = IsMajsoulFair::permutation_to_interval_batch_stride;
+
+// With at most four steps per round, every multiplier is below 136^4 < 2^29,
+// so a 32-bit limb times a multiplier plus both carries fits in 64 bits.
+constexpr std::size_t max_steps_per_round = 4u;
+
+constexpr std::uint64_t limb_mask = 0xFFFFFFFFu;
+
+// A round maps `(lower, difference)` to
+// `(lower * factor + difference * offset, difference * count)` in every lane.
+struct Round
+{
+  std::uint64_t factor;
+  std::array<std::uint64_t, num_lanes> offsets;
+  std::array<std::uint64_t, num_lanes> counts;
+}; // struct Round
+
+// `prefix_sums[t]`, the number of remaining tiles whose codes are less than
+// `t`, is kept packed as bytes into words so that removing a tile updates all
+// of them with a few word subtractions. No byte ever borrows, since every
+// byte that is decremented counts the removed tile.
+using PackedPrefixSums = std::array<std::uint64_t, 5u>;
+
+constexpr std::array<PackedPrefixSums, 37u> decrement_masks = []() {
+  std::array<PackedPrefixSums, 37u> masks{};
+  for (std::size_t tile = 0u; tile < 37u; ++tile) {
+    for (std::size_t t = tile + 1u; t < 37u; ++t) {
+      masks[tile][t / 8u] |= std::uint64_t(1u) << (8u * (t % 8u));
+    }
+  }
+  return masks;
+}();
+
+// The packed prefix sums of a full wall of `TileSet`.
+template<typename TileSet>
+constexpr PackedPrefixSums initial_prefix_sums = []() {
+  PackedPrefixSums prefix_sums{};
+  std::uint64_t sum = 0u;
+  for (std::size_t t = 0u; t < TileSet::num_tiles_per_code.size(); ++t) {
+    prefix_sums[t / 8u] |= sum << (8u * (t % 8u));
+    sum += TileSet::num_tiles_per_code[t];
+  }
+  return prefix_sums;
+}();
+
+// Fills `offsets[i]` with the number of remaining tiles that precede
+// `permutation[i]` and `counts[i]` with the number of remaining copies of it.
+template<typename TileSet>
+void decompose(
+  std::span<std::uint8_t const> const permutation,
+  std::vector<std::uint8_t> &offsets,
+  std::vector<std::uint8_t> &counts)
+{
+  static_assert(TileSet::num_tiles <= max_length);
+
+  std::array<std::uint8_t, 37u> num_tiles;
+  std::copy(TileSet::num_tiles_per_code.cbegin(), TileSet::num_tiles_per_code.cend(), num_tiles.begin());
+  PackedPrefixSums prefix_sums = initial_prefix_sums<TileSet>;
+
+  offsets.resize(permutation.size());
+  counts.resize(permutation.size());
+  for (std::size_t i = 0u; i < permutation.size(); ++i) {
+    std::uint_fast8_t const tile = permutation[i];
+    if (i >= TileSet::num_tiles || tile >= num_tiles.size() || num_tiles[tile] == 0u) {
+      // Lets the scalar path report the error in its own words.
+      IsMajsoulFair::permutationToInterval(
+        std::vector<std::uint_fast8_t>(permutation.begin(), permutation.end()), TileSet());
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    }
+    offsets[i] = static_cast<std::uint8_t>(prefix_sums[tile / 8u] >> (8u * (tile % 8u)));
+    counts[i] = num_tiles[tile];
+    --num_tiles[tile];
+    for (std::size_t k = 0u; k < prefix_sums.size(); ++k) {
+      prefix_sums[k] -= decrement_masks[tile][k];
+    }
+  }
+}
+
+void advanceLanesPortable(
+  Round const &round, std::size_t const num_limbs, std::uint64_t * const lower, std::uint64_t * const difference)
+{
+  std::array<std::uint64_t, num_lanes> lower_carries{};
+  std::array<std::uint64_t, num_lanes> difference_carries{};
+  for (std::size_t i = 0u; i < num_limbs; ++i) {
+    std::uint64_t * const l = lower + i * num_lanes;
+    std::uint64_t * const d = difference + i * num_lanes;
+    for (std::size_t j = 0u; j < num_lanes; ++j) {
+      std::uint64_t const t = l[j] * round.factor + d[j] * round.offsets[j] + lower_carries[j];
+      std::uint64_t const u = d[j] * round.counts[j] + difference_carries[j];
+      l[j] = t & limb_mask;
+      lower_carries[j] = t >> 32u;
+      d[j] = u & limb_mask;
+      difference_carries[j] = u >> 32u;
+    }
+  }
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+void advanceLanesAVX2(
+  Round const &round, std::size_t const num_limbs, std::uint64_t * const lower, std::uint64_t * const difference)
+{
+  static_assert(num_lanes == 8u);
+
+  __m256i const factor = _mm256_set1_epi64x(static_cast<long long>(round.factor));
+  __m256i const offsets0 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(round.offsets.data()));
+  __m256i const offsets1 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(round.offsets.data() + 4u));
+  __m256i const counts0 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(round.counts.data()));
+  __m256i const counts1 = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(round.counts.data() + 4u));
+  __m256i const mask = _mm256_set1_epi64x(static_cast<long long>(limb_mask));
+
+  __m256i lower_carry0 = _mm256_setzero_si256();
+  __m256i lower_carry1 = _mm256_setzero_si256();
+  __m256i difference_carry0 = _mm256_setzero_si256();
+  __m256i difference_carry1 = _mm256_setzero_si256();
+  for (std::size_t i = 0u; i < num_limbs; ++i) {
+    __m256i * const l = reinterpret_cast<__m256i *>(lower + i * num_lanes);
+    __m256i * const d = reinterpret_cast<__m256i *>(difference + i * num_lanes);
+    __m256i const l0 = _mm256_loadu_si256(l);
+    __m256i const l1 = _mm256_loadu_si256(l + 1);
+    __m256i const d0 = _mm256_loadu_si256(d);
+    __m256i const d1 = _mm256_loadu_si256(d + 1);
+
+    __m256i const t0 = _mm256_add_epi64(
+      _mm256_add_epi64(_mm256_mul_epu32(l0, factor), _mm256_mul_epu32(d0, offsets0)), lower_carry0);
+    __m256i const t1 = _mm256_add_epi64(
+      _mm256_add_epi64(_mm256_mul_epu32(l1, factor), _mm256_mul_epu32(d1, offsets1)), lower_carry1);
+    __m256i const u0 = _mm256_add_epi64(_mm256_mul_epu32(d0, counts0), difference_carry0);
+    __m256i const u1 = _mm256_add_epi64(_mm256_mul_epu32(d1, counts1), difference_carry1);
+
+    _mm256_storeu_si256(l, _mm256_and_si256(t0, mask));
+    _mm256_storeu_si256(l + 1, _mm256_and_si256(t1, mask));
+    _mm256_storeu_si256(d, _mm256_and_si256(u0, mask));
+    _mm256_storeu_si256(d + 1, _mm256_and_si256(u1, mask));
+    lower_carry0 = _mm256_srli_epi64(t0, 32);
+    lower_carry1 = _mm256_srli_epi64(t1, 32);
+    difference_carry0 = _mm256_srli_epi64(u0, 32);
+    difference_carry1 = _mm256_srli_epi64(u1, 32);
+  }
+}
+
+#endif // defined(__x86_64__)
+
+using AdvanceLanes = void (*)(Round const &, std::size_t, std::uint64_t *, std::uint64_t *);
+
+AdvanceLanes selectAdvanceLanes()
+{
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("avx2")) {
+    return &advanceLanesAVX2;
+  }
+#endif // defined(__x86_64__)
+  return &advanceLanesPortable;
+}
+
+void importLane(
+  std::uint64_t const * const limbs, std::size_t const num_limbs, std::size_t const lane,
+  std::vector<unsigned char> &buffer, IsMajsoulFair::Integer &result)
+{
+  buffer.resize(4u * num_limbs);
+  for (std::size_t i = 0u; i < num_limbs; ++i) {
+    std::uint64_t const limb = limbs[i * num_lanes + lane];
+    buffer[4u * i + 0u] = static_cast<unsigned char>(limb >> 0u);
+    buffer[4u * i + 1u] = static_cast<unsigned char>(limb >> 8u);
+    buffer[4u * i + 2u] = static_cast<unsigned char>(limb >> 16u);
+    buffer[4u * i + 3u] = static_cast<unsigned char>(limb >> 24u);
+  }
+  result.importBits(buffer.data(), 8u * buffer.size(), IsMajsoulFair::BitOrder::least_significant_first);
+}
+
+// Writes `permutationToInterval(permutations[i], TileSet())` to `intervals[i]`.
+template<typename TileSet>
+void encode(
+  std::vector<std::span<std::uint8_t const>> const &permutations,
+  std::vector<IsMajsoulFair::Interval> &intervals)
+{
+  static AdvanceLanes const advance_lanes = selectAdvanceLanes();
+
+  std::vector<std::size_t> order(permutations.size());
+  std::iota(order.begin(), order.end(), 0u);
+  std::stable_sort(order.begin(), order.end(), [&](std::size_t const lhs, std::size_t const rhs) {
+    return permutations[lhs].size() < permutations[rhs].size();
+  });
+
+  std::array<std::vector<std::uint8_t>, num_lanes> offsets;
+  std::array<std::vector<std::uint8_t>, num_lanes> counts;
+  std::vector<std::uint64_t> lower;
+  std::vector<std::uint64_t> difference;
+  std::vector<unsigned char> buffer;
+  IsMajsoulFair::Integer denominator;
+  IsMajsoulFair::Integer lower_numerator;
+  IsMajsoulFair::Integer upper_numerator;
+  for (std::size_t first = 0u; first < order.size();) {
+    std::size_t const length = permutations[order[first]].size();
+    std::size_t last = first;
+    while (last < order.size() && last - first < num_lanes && permutations[order[last]].size() == length) {
+      ++last;
+    }
+
+    for (std::size_t j = 0u; j < num_lanes; ++j) {
+      std::size_t const index = order[first + std::min(j, last - first - 1u)];
+      decompose<TileSet>(permutations[index], offsets[j], counts[j]);
+    }
+
+    std::size_t const max_limbs = (8u * length + 31u) / 32u + 1u;
+    lower.assign(max_limbs * num_lanes, 0u);
+    difference.assign(max_limbs * num_lanes, 0u);
+    std::fill_n(difference.begin(), num_lanes, 1u);
+
+    denominator = 1ul;
+    for (std::size_t step = 0u; step < length; step += max_steps_per_round) {
+      Round round;
+      round.factor = 1u;
+      round.offsets.fill(0u);
+      round.counts.fill(1u);
+      for (std::size_t i = step; i < std::min(step + max_steps_per_round, length); ++i) {
+        std::uint64_t const factor = TileSet::num_tiles - i;
+        for (std::size_t j = 0u; j < num_lanes; ++j) {
+          round.offsets[j] = round.offsets[j] * factor + round.counts[j] * offsets[j][i];
+          round.counts[j] *= counts[j][i];
+        }
+        round.factor *= factor;
+      }
+      denominator *= static_cast<unsigned long>(round.factor);
+      std::size_t const num_limbs = (denominator.bitLength() + 31u) / 32u;
+      advance_lanes(round, num_limbs, lower.data(), difference.data());
+    }
+
+    std::size_t const num_limbs = (denominator.bitLength() + 31u) / 32u;
+    for (std::size_t j = 0u; j < last - first; ++j) {
+      importLane(lower.data(), num_limbs, j, buffer, lower_numerator);
+      importLane(difference.data(), num_limbs, j, buffer, upper_numerator);
+      upper_numerator += lower_numerator;
+      intervals[order[first + j]].assign(denominator, lower_numerator, upper_numerator);
+    }
+
+    first = last;
+  }
+}
+
+} // namespace <unnamed>
+
+std::vector<IsMajsoulFair::Interval> permutationToIntervalBatch(
+  std::vector<std::vector<std::uint_fast8_t>> const &permutations)
+{
+  std::vector<std::span<std::uint8_t const>> views;
+  views.reserve(permutations.size());
+  for (std::vector<std::uint_fast8_t> const &permutation : permutations) {
+    views.emplace_back(permutation.data(), permutation.size());
+  }
+
+  std::vector<IsMajsoulFair::Interval> intervals(permutations.size());
+  encode<IsMajsoulFair::FourPlayerTileSet>(views, intervals);
+  return intervals;
+}
+
+template<typename TileSet>
+void permutationToIntervalBatch(
+  std::span<std::uint8_t const> const tiles,
+  std::span<std::uint8_t const> const lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals)
+{
+  if (tiles.size() != max_length * lengths.size()) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`tiles` must hold exactly one row per element of `lengths`.");
+  }
+
+  std::vector<std::span<std::uint8_t const>> views;
+  views.reserve(lengths.size());
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    if (lengths[i] > max_length) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("An element of `lengths` is too large.");
+    }
+    views.push_back(tiles.subspan(max_length * i, lengths[i]));
+  }
+
+  if (intervals.size() < lengths.size()) {
+    intervals.resize(lengths.size());
+  }
+  encode<TileSet>(views, intervals);
+}
+
+void permutationToIntervalBatch(
+  std::span<std::uint8_t const> const tiles,
+  std::span<std::uint8_t const> const lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals)
+{
+  IsMajsoulFair::permutationToIntervalBatch<IsMajsoulFair::FourPlayerTileSet>(tiles, lengths, intervals);
+}
+
+template void permutationToIntervalBatch<IsMajsoulFair::FourPlayerTileSet>(
+  std::span<std::uint8_t const> tiles,
+  std::span<std::uint8_t const> lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals);
+
+template void permutationToIntervalBatch<IsMajsoulFair::ThreePlayerTileSet>(
+  std::span<std::uint8_t const> tiles,
+  std::span<std::uint8_t const> lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals);
+
+} // namespace IsMajsoulFair
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_PERMUTATION_TO_INTERVAL_BATCH_HPP)
+#define CORE_PERMUTATION_TO_INTERVAL_BATCH_HPP
+
+#include "interval.hpp"
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// Returns `permutationToInterval(p)` for every `p` in `permutations`.
+// Permutations of the same length share every multiplier of the denominator,
+// so they are advanced in lockstep, one lane per permutation, in a
+// structure-of-arrays limb layout. The lanes are advanced with AVX2 when the
+// CPU supports it, and with a portable loop otherwise.
+std::vector<IsMajsoulFair::Interval> permutationToIntervalBatch(
+  std::vector<std::vector<std::uint_fast8_t>> const &permutations);
+
+// The number of bytes per row of the flat buffer taken by the overload below.
+inline constexpr std::size_t permutation_to_interval_batch_stride = 136u;
+
+// The same as above, but for `lengths.size()` rows of
+// `permutation_to_interval_batch_stride` bytes laid out back to back in
+// `tiles`, row `i` starting with a permutation of `lengths[i]` tiles. The
+// interval of row `i` is written to `intervals[i]`; `intervals` is only ever
+// grown, and the integers it already owns are reused, so that a caller that
+// keeps it across calls does not allocate per permutation.
+void permutationToIntervalBatch(
+  std::span<std::uint8_t const> tiles,
+  std::span<std::uint8_t const> lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals);
+
+// The same as above, but for walls of the tile set `TileSet`, e.g.,
+// `ThreePlayerTileSet`. Explicitly instantiated for the tile sets of
+// `tile_set.hpp`.
+template<typename TileSet>
+void permutationToIntervalBatch(
+  std::span<std::uint8_t const> tiles,
+  std::span<std::uint8_t const> lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals);
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_PERMUTATION_TO_INTERVAL_BATCH_HPP)
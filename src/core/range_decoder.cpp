@@ -0,0 +1,239 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "range_decoder.hpp"
+
+#include "interval_to_binary.hpp"
+#include "permutation_to_interval.hpp"
+#include "interval.hpp"
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <span>
+#include <vector>
+#include <array>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+constexpr unsigned __int128 half = static_cast<unsigned __int128>(1u) << 63u;
+
+constexpr unsigned __int128 one = static_cast<unsigned __int128>(1u) << 64u;
+
+constexpr unsigned __int128 low_mask = one - 1u;
+
+} // namespace <unnamed>
+
+namespace IsMajsoulFair{
+
+RangeDecoder::RangeDecoder(
+  std::array<std::uint_fast8_t, 37u> const &num_tiles,
+  std::size_t const num_bits,
+  IsMajsoulFair::RangeDecoderMode const mode)
+  : num_tiles_(num_tiles),
+    num_bits_(num_bits),
+    exact_(false),
+    num_remaining_tiles_(),
+    num_remaining_(),
+    low_(),
+    range_(),
+    cache_(),
+    num_pending_ones_(),
+    is_integer_part_(),
+    bits_(),
+    tiles_()
+{
+  std::size_t length = 0u;
+  for (std::uint_fast8_t const num : num_tiles_) {
+    length += num;
+  }
+  if (length == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("The multiset of tiles must not be empty.");
+  }
+
+  // `sum(r)` over the steps of a full permutation.
+  std::size_t const sum_remaining = length * (length + 1u) / 2u;
+  if (sum_remaining > std::size_t(1u) << (63u - guard_bits)) {
+    if (mode == IsMajsoulFair::RangeDecoderMode::fixed_precision) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+        << length << ": Too many tiles to be extracted in fixed precision.";
+    }
+    exact_ = true;
+  }
+
+  reset_();
+}
+
+bool RangeDecoder::isExact() const noexcept
+{
+  return exact_;
+}
+
+void RangeDecoder::push(std::uint_fast8_t const tile)
+{
+  if (tile >= num_remaining_tiles_.size() || num_remaining_tiles_[tile] == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << static_cast<unsigned>(tile) << ": The tile is not in the multiset, or appears too many times.";
+  }
+
+  std::size_t cumulative = 0u;
+  for (std::uint_fast8_t t = 0u; t < tile; ++t) {
+    cumulative += num_remaining_tiles_[t];
+  }
+  std::size_t const count = num_remaining_tiles_[tile];
+  std::size_t const num_remaining = num_remaining_;
+  --num_remaining_tiles_[tile];
+  --num_remaining_;
+
+  if (exact_) {
+    tiles_.push_back(tile);
+    return;
+  }
+  if (bits_.size() == num_bits_) {
+    // The rest of the paishan cannot change the output.
+    return;
+  }
+
+  // `floor(range * c / r)` as `q * c + floor(m * c / r)` for
+  // `range = q * r + m`, so that every division is 64-bit. Only the initial
+  // range, `2^64`, does not fit in 64 bits.
+  unsigned __int128 quotient;
+  std::uint64_t remainder;
+  if (range_ == one) {
+    quotient = static_cast<unsigned __int128>(UINT64_MAX / num_remaining);
+    remainder = UINT64_MAX % num_remaining + 1u;
+    if (remainder == num_remaining) {
+      ++quotient;
+      remainder = 0u;
+    }
+  }
+  else {
+    std::uint64_t const range = static_cast<std::uint64_t>(range_);
+    quotient = range / num_remaining;
+    remainder = range % num_remaining;
+  }
+  unsigned __int128 const lower = quotient * cumulative + remainder * cumulative / num_remaining;
+  unsigned __int128 const upper
+    = quotient * (cumulative + count) + remainder * (cumulative + count) / num_remaining;
+  low_ += lower;
+  range_ = upper - lower;
+  while (range_ <= half) {
+    shift_();
+    range_ <<= 1u;
+  }
+}
+
+std::span<unsigned char const> RangeDecoder::getDeterminedBits() const noexcept
+{
+  return bits_;
+}
+
+std::vector<unsigned char> RangeDecoder::finish(IsMajsoulFair::IntegerRandomState &state)
+{
+  if (exact_) {
+    IsMajsoulFair::Interval const interval = IsMajsoulFair::permutationToInterval(tiles_, num_tiles_);
+    std::vector<unsigned char> result = IsMajsoulFair::intervalToBinary(interval, num_bits_, state);
+    reset_();
+    return result;
+  }
+
+  if (bits_.size() < num_bits_) {
+    // An offset drawn uniformly from `[0, range)` by Lemire's method.
+    std::uint64_t offset;
+    if (range_ == one) {
+      offset = state();
+    }
+    else {
+      std::uint64_t const range = static_cast<std::uint64_t>(range_);
+      std::uint64_t const threshold = -range % range;
+      while (true) {
+        unsigned __int128 const product = static_cast<unsigned __int128>(state()) * range;
+        if (static_cast<std::uint64_t>(product) >= threshold) {
+          offset = static_cast<std::uint64_t>(product >> 64u);
+          break;
+        }
+      }
+    }
+    low_ += offset;
+
+    // Flushes the 64 bits of `low`, and then the cache and the pending ones.
+    for (std::size_t i = 0u; i <= 64u && bits_.size() < num_bits_; ++i) {
+      shift_();
+    }
+
+    // The bits below the precision are those of a uniform point of the last
+    // unit, which never carries into the bits above.
+    while (bits_.size() < num_bits_) {
+      std::uint64_t const word = state();
+      for (std::size_t i = 0u; i < 64u && bits_.size() < num_bits_; ++i) {
+        bits_.push_back(word >> (63u - i) & 1u);
+      }
+    }
+  }
+
+  std::vector<unsigned char> result = std::move(bits_);
+  reset_();
+  return result;
+}
+
+void RangeDecoder::emit_(unsigned char const bit)
+{
+  if (bit > 1u) {
+    IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+  }
+  if (is_integer_part_) {
+    // Every point lies in `[0, 1)`.
+    if (bit != 0u) {
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    }
+    is_integer_part_ = false;
+    return;
+  }
+  if (bits_.size() < num_bits_) {
+    bits_.push_back(bit);
+  }
+}
+
+void RangeDecoder::shift_()
+{
+  // The bit shifted out is held back, as `cache_` followed by
+  // `num_pending_ones_` ones, until a zero bit or a carry settles it.
+  if (low_ < half || low_ >= one) {
+    unsigned char const carry = static_cast<unsigned char>(low_ >> 64u);
+    emit_(cache_ + carry);
+    for (; num_pending_ones_ > 0u; --num_pending_ones_) {
+      emit_(1u - carry);
+    }
+    cache_ = static_cast<unsigned char>(low_ >> 63u & 1u);
+  }
+  else {
+    ++num_pending_ones_;
+  }
+  low_ = low_ << 1u & low_mask;
+}
+
+void RangeDecoder::reset_()
+{
+  num_remaining_tiles_ = num_tiles_;
+  num_remaining_ = 0u;
+  for (std::uint_fast8_t const num : num_tiles_) {
+    num_remaining_ += num;
+  }
+  low_ = 0u;
+  range_ = one;
+  cache_ = 0u;
+  num_pending_ones_ = 0u;
+  is_integer_part_ = true;
+  bits_.clear();
+  bits_.reserve(num_bits_);
+  tiles_.clear();
+}
+
+} // namespace IsMajsoulFair
@@ -0,0 +1,104 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_RANGE_DECODER_HPP)
+#define CORE_RANGE_DECODER_HPP
+
+#include "integer.hpp"
+#include <span>
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+enum class RangeDecoderMode
+{
+  // Always runs in fixed precision, and refuses multisets that fail the guard.
+  fixed_precision,
+  // Runs in fixed precision when the multiset passes the guard, and otherwise
+  // keeps the tiles and runs `intervalToBinary` on their exact interval.
+  exact_fallback
+}; // enum class RangeDecoderMode
+
+// An alternative to `intervalToBinary(permutationToInterval(p), n, state)`
+// that works like the encoder half of a range coder run as a bit extractor.
+// The state is a 64-bit `low` and a range in `(2^63, 2^64]`, renormalized bit
+// by bit, and each tile narrows it with fixed-precision arithmetic. Leading
+// bits are emitted as soon as no carry can reach them, so memory is constant
+// apart from the output, and no GMP integer is touched.
+//
+// How the output differs from the exact path: the exact path outputs the
+// leading `n` bits of a point drawn uniformly from the exact interval `I(p)`
+// of `p`. The decoder builds its interval `J(p)` by the same recursion, except
+// that every split point is rounded down to the current precision, and
+// outputs the leading `n` bits of a point drawn uniformly from `J(p)`. Hence
+//
+// - For a given paishan, the output is not that of the exact path, bit for
+//   bit or in distribution, because `J(p)` is not `I(p)`. The endpoints of
+//   the two differ by less than `N 2^-64` for `N` tiles, so the leading bits
+//   agree unless a cell boundary falls that close to them.
+// - The `J(p)` still partition `[0, 1)`, and each step scales the width of a
+//   cell by a factor within `1 +- r / 2^63`, where `r` is the number of tiles
+//   remaining before the step. So `|J(p)| / |I(p)|` is within
+//   `exp(+-epsilon)` for `epsilon = sum(r) / 2^63 <= N (N + 1) / 2^64`, and for
+//   a uniformly drawn paishan every `n`-bit string is output with probability
+//   within `exp(+-epsilon)` of `2^-n`, where the exact path gives exactly
+//   `2^-n`. For 136 tiles, `epsilon < 2^-50`.
+//
+// The guard requires `epsilon <= 2^-guard_bits` for the full multiset of `N`
+// tiles. Bit-by-bit renormalization with carry propagation keeps the range
+// from ever underflowing at run time, so the guard is decided once from the
+// multiset.
+class RangeDecoder
+{
+public:
+  static constexpr std::size_t guard_bits = 40u;
+
+  RangeDecoder(
+    std::array<std::uint_fast8_t, 37u> const &num_tiles,
+    std::size_t num_bits,
+    IsMajsoulFair::RangeDecoderMode mode = IsMajsoulFair::RangeDecoderMode::exact_fallback);
+
+  // Whether the multiset failed the guard and the exact path is taken.
+  bool isExact() const noexcept;
+
+  // Narrows the state by the next tile of the paishan.
+  void push(std::uint_fast8_t tile);
+
+  // The leading bits of the output that are already determined, one bit per
+  // element, most significant first. Always empty on the exact path.
+  std::span<unsigned char const> getDeterminedBits() const noexcept;
+
+  // Draws a point of the interval of the tiles pushed so far, returns its
+  // leading `num_bits` bits, one bit per element, and starts over for the
+  // next paishan.
+  std::vector<unsigned char> finish(IsMajsoulFair::IntegerRandomState &state);
+
+private:
+  void emit_(unsigned char bit);
+
+  void shift_();
+
+  void reset_();
+
+  std::array<std::uint_fast8_t, 37u> num_tiles_;
+  std::size_t num_bits_;
+  bool exact_;
+  std::array<std::uint_fast8_t, 37u> num_remaining_tiles_;
+  std::size_t num_remaining_;
+  unsigned __int128 low_;
+  unsigned __int128 range_;
+  unsigned char cache_;
+  std::size_t num_pending_ones_;
+  bool is_integer_part_;
+  std::vector<unsigned char> bits_;
+  std::vector<std::uint_fast8_t> tiles_;
+}; // class RangeDecoder
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_RANGE_DECODER_HPP)
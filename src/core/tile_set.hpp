@@ -0,0 +1,104 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_TILE_SET_HPP)
+#define CORE_TILE_SET_HPP
+
+#include <concepts>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// A compile-time policy describing the tiles a wall is built from. Tile codes
+// are `0` for the red 5m, `1`--`9` for 1m--9m, `10`--`19` and `20`--`29`
+// likewise for pinzu and souzu, and `30`--`36` for honors. Tile ids, as in
+// a shuffle of the physical tiles, enumerate every suit as 1--4, the red
+// five, the remaining fives and 6--9, and then the honors.
+template<std::array<std::uint_fast8_t, 37u> NumTilesPerCode, std::size_t NumPartialTiles>
+struct BasicTileSet
+{
+  static constexpr std::array<std::uint_fast8_t, 37u> num_tiles_per_code = NumTilesPerCode;
+
+  static constexpr std::size_t num_tiles = []() {
+    std::size_t result = 0u;
+    for (std::uint_fast8_t const num : NumTilesPerCode) {
+      result += num;
+    }
+    return result;
+  }();
+
+  // The length of the prefix of a wall that partial records keep.
+  static constexpr std::size_t num_partial_tiles = NumPartialTiles;
+
+  static constexpr std::size_t num_codes = []() {
+    std::size_t result = 0u;
+    for (std::uint_fast8_t const num : NumTilesPerCode) {
+      result += num != 0u ? 1u : 0u;
+    }
+    return result;
+  }();
+
+  static constexpr std::array<std::uint_fast8_t, num_tiles> id_to_code = []() {
+    std::array<std::uint_fast8_t, num_tiles> result{};
+    std::size_t id = 0u;
+    auto const append = [&](std::uint_fast8_t const code) {
+      for (std::uint_fast8_t i = 0u; i < NumTilesPerCode[code]; ++i) {
+        result[id++] = code;
+      }
+    };
+    for (std::uint_fast8_t suit = 0u; suit < 3u; ++suit) {
+      for (std::uint_fast8_t number = 1u; number <= 4u; ++number) {
+        append(10u * suit + number);
+      }
+      append(10u * suit);
+      for (std::uint_fast8_t number = 5u; number <= 9u; ++number) {
+        append(10u * suit + number);
+      }
+    }
+    for (std::uint_fast8_t code = 30u; code < 37u; ++code) {
+      append(code);
+    }
+    return result;
+  }();
+}; // struct BasicTileSet
+
+// The 136 tiles of four-player games, with a red five in every suit.
+using FourPlayerTileSet = BasicTileSet<
+  std::array<std::uint_fast8_t, 37u>{
+    1u, 4u, 4u, 4u, 4u, 3u, 4u, 4u, 4u, 4u,
+    1u, 4u, 4u, 4u, 4u, 3u, 4u, 4u, 4u, 4u,
+    1u, 4u, 4u, 4u, 4u, 3u, 4u, 4u, 4u, 4u,
+    4u, 4u, 4u, 4u, 4u, 4u, 4u},
+  83u>;
+
+// The 108 tiles of three-player games, without 2m--8m and the red 5m.
+using ThreePlayerTileSet = BasicTileSet<
+  std::array<std::uint_fast8_t, 37u>{
+    0u, 4u, 0u, 0u, 0u, 0u, 0u, 0u, 0u, 4u,
+    1u, 4u, 4u, 4u, 4u, 3u, 4u, 4u, 4u, 4u,
+    1u, 4u, 4u, 4u, 4u, 3u, 4u, 4u, 4u, 4u,
+    4u, 4u, 4u, 4u, 4u, 4u, 4u},
+  68u>;
+
+template<typename T>
+concept TileSetPolicy = requires {
+  { T::num_tiles_per_code } -> std::convertible_to<std::array<std::uint_fast8_t, 37u>>;
+  { T::num_tiles } -> std::convertible_to<std::size_t>;
+  { T::num_partial_tiles } -> std::convertible_to<std::size_t>;
+  { T::num_codes } -> std::convertible_to<std::size_t>;
+  T::id_to_code;
+};
+
+static_assert(IsMajsoulFair::TileSetPolicy<IsMajsoulFair::FourPlayerTileSet>);
+static_assert(IsMajsoulFair::TileSetPolicy<IsMajsoulFair::ThreePlayerTileSet>);
+
+static_assert(IsMajsoulFair::FourPlayerTileSet::num_tiles == 136u);
+static_assert(IsMajsoulFair::ThreePlayerTileSet::num_tiles == 108u);
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_TILE_SET_HPP)
@@ -0,0 +1,292 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "toeplitz_extractor.hpp"
+
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <span>
+#include <vector>
+#include <array>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstddef>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif // defined(__x86_64__)
+
+
+namespace IsMajsoulFair{
+
+namespace{
+
+using std::placeholders::_1;
+
+constexpr std::size_t getNumWords(std::size_t const num_bits) noexcept
+{
+  return (num_bits + 63u) / 64u;
+}
+
+// The carry-less product of two words, as the low and the high words.
+struct CarrylessProduct
+{
+  std::uint64_t low;
+  std::uint64_t high;
+}; // struct CarrylessProduct
+
+// Multiplies words by a fixed word `y`, four bits at a time, from a table of
+// the products of `y` and every 4-bit polynomial. The products spill over the
+// low word by at most three bits, which are kept in `spills_`.
+class PortableMultiplier
+{
+public:
+  explicit PortableMultiplier(std::uint64_t const y) noexcept
+    : table_(),
+      spills_()
+  {
+    for (std::size_t i = 1u; i < 16u; ++i) {
+      for (std::size_t j = 0u; j < 4u; ++j) {
+        if ((i >> j & 1u) != 0u) {
+          table_[i] ^= y << j;
+          spills_[i] ^= j == 0u ? 0u : y >> (64u - j);
+        }
+      }
+    }
+  }
+
+  CarrylessProduct operator()(std::uint64_t const x) const noexcept
+  {
+    CarrylessProduct result{0u, 0u};
+    for (std::size_t i = 64u; i > 0u; i -= 4u) {
+      std::size_t const nibble = x >> (i - 4u) & 0xFu;
+      result.high = result.high << 4u | result.low >> 60u;
+      result.low = result.low << 4u ^ table_[nibble];
+      result.high ^= spills_[nibble];
+    }
+    return result;
+  }
+
+private:
+  std::array<std::uint64_t, 16u> table_;
+  std::array<std::uint64_t, 16u> spills_;
+}; // class PortableMultiplier
+
+#if defined(__x86_64__)
+
+class PCLMULMultiplier
+{
+public:
+  __attribute__((target("pclmul")))
+  explicit PCLMULMultiplier(std::uint64_t const y) noexcept
+    : y_(_mm_cvtsi64_si128(static_cast<long long>(y)))
+  {}
+
+  __attribute__((target("pclmul")))
+  CarrylessProduct operator()(std::uint64_t const x) const noexcept
+  {
+    __m128i const product = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(x)), y_, 0x00);
+    return {
+      static_cast<std::uint64_t>(_mm_cvtsi128_si64(product)),
+      static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(product, product)))};
+  }
+
+private:
+  __m128i y_;
+}; // class PCLMULMultiplier
+
+#endif // defined(__x86_64__)
+
+// Words `[first_word, first_word + product.size())` of the carry-less
+// product of `seed` and `input`, into `product`.
+template<typename Multiplier>
+[[gnu::always_inline]] inline void multiplyWindow(
+  std::span<std::uint64_t const> const seed,
+  std::span<std::uint64_t const> const input,
+  std::size_t const first_word,
+  std::span<std::uint64_t> const product)
+{
+  for (std::uint64_t &word : product) {
+    word = 0u;
+  }
+  std::size_t const last_word = first_word + product.size();
+  for (std::size_t i = 0u; i < input.size(); ++i) {
+    if (input[i] == 0u) {
+      continue;
+    }
+    Multiplier const multiply(input[i]);
+    // The low word of `seed[j] input[i]` goes to word `i + j`, and the high
+    // word to `i + j + 1`.
+    std::size_t const first_j = first_word > i + 1u ? first_word - i - 1u : 0u;
+    for (std::size_t j = first_j; j < seed.size() && i + j < last_word; ++j) {
+      CarrylessProduct const p = multiply(seed[j]);
+      if (i + j >= first_word) {
+        product[i + j - first_word] ^= p.low;
+      }
+      if (i + j + 1u < last_word) {
+        product[i + j + 1u - first_word] ^= p.high;
+      }
+    }
+  }
+}
+
+void multiplyWindowPortable(
+  std::span<std::uint64_t const> const seed,
+  std::span<std::uint64_t const> const input,
+  std::size_t const first_word,
+  std::span<std::uint64_t> const product)
+{
+  multiplyWindow<PortableMultiplier>(seed, input, first_word, product);
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("pclmul")))
+void multiplyWindowPCLMUL(
+  std::span<std::uint64_t const> const seed,
+  std::span<std::uint64_t const> const input,
+  std::size_t const first_word,
+  std::span<std::uint64_t> const product)
+{
+  multiplyWindow<PCLMULMultiplier>(seed, input, first_word, product);
+}
+
+#endif // defined(__x86_64__)
+
+using MultiplyWindow = void (*)(
+  std::span<std::uint64_t const>, std::span<std::uint64_t const>, std::size_t, std::span<std::uint64_t>);
+
+MultiplyWindow selectMultiplyWindow()
+{
+#if defined(__x86_64__)
+  if (__builtin_cpu_supports("pclmul")) {
+    return &multiplyWindowPCLMUL;
+  }
+#endif // defined(__x86_64__)
+  return &multiplyWindowPortable;
+}
+
+std::vector<std::uint64_t> drawSeed(
+  std::size_t const num_input_bits, std::size_t const num_output_bits, IsMajsoulFair::IntegerRandomState &state)
+{
+  std::vector<std::uint64_t> seed(getNumWords(num_input_bits + num_output_bits - 1u));
+  for (std::uint64_t &word : seed) {
+    word = state();
+  }
+  return seed;
+}
+
+} // namespace <unnamed>
+
+ToeplitzExtractor::ToeplitzExtractor(
+  std::size_t const num_input_bits, std::size_t const num_output_bits, IsMajsoulFair::IntegerRandomState &state)
+  : ToeplitzExtractor(
+      num_input_bits,
+      num_output_bits,
+      num_input_bits == 0u || num_output_bits == 0u
+        ? std::vector<std::uint64_t>() : drawSeed(num_input_bits, num_output_bits, state))
+{}
+
+ToeplitzExtractor::ToeplitzExtractor(
+  std::size_t const num_input_bits, std::size_t const num_output_bits, std::vector<std::uint64_t> seed)
+  : num_input_bits_(num_input_bits),
+    num_output_bits_(num_output_bits),
+    seed_(std::move(seed))
+{
+  if (num_input_bits_ == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("The number of the input bits must be positive.");
+  }
+  if (num_output_bits_ == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("The number of the output bits must be positive.");
+  }
+  std::size_t const num_seed_bits = num_input_bits_ + num_output_bits_ - 1u;
+  if (seed_.size() != getNumWords(num_seed_bits)) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << seed_.size() << ": The seed must be " << getNumWords(num_seed_bits) << " words.";
+  }
+  // The bits above the seed would otherwise leak into the product.
+  if (num_seed_bits % 64u != 0u) {
+    seed_.back() &= (std::uint64_t(1u) << num_seed_bits % 64u) - 1u;
+  }
+}
+
+std::size_t ToeplitzExtractor::getNumInputBits() const noexcept
+{
+  return num_input_bits_;
+}
+
+std::size_t ToeplitzExtractor::getNumOutputBits() const noexcept
+{
+  return num_output_bits_;
+}
+
+void ToeplitzExtractor::extract(std::span<std::uint64_t const> const input, std::span<std::uint64_t> const output) const
+{
+  static MultiplyWindow const multiply_window = selectMultiplyWindow();
+
+  if (input.size() != getNumWords(num_input_bits_)) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << input.size() << ": The input must be " << getNumWords(num_input_bits_) << " words.";
+  }
+  if (output.size() != getNumWords(num_output_bits_)) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << output.size() << ": The output must be " << getNumWords(num_output_bits_) << " words.";
+  }
+  if (num_input_bits_ % 64u != 0u && input.back() >> num_input_bits_ % 64u != 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("The input has bits above `num_input_bits`.");
+  }
+
+  // With `c = s x`, `y_i = sum_j s_(i - j + n - 1) x_j = c_(i + n - 1)` for
+  // `n` input bits, so `y` is bits `[n - 1, n - 1 + m)` of `c`.
+  std::size_t const first_bit = num_input_bits_ - 1u;
+  std::size_t const first_word = first_bit / 64u;
+  std::size_t const shift = first_bit % 64u;
+  // One more word than the output for the shift.
+  std::array<std::uint64_t, 64u> window;
+  std::vector<std::uint64_t> buffer;
+  std::span<std::uint64_t> product;
+  std::size_t const num_window_words = output.size() + 1u;
+  if (num_window_words <= window.size()) {
+    product = std::span<std::uint64_t>(window.data(), num_window_words);
+  }
+  else {
+    buffer.resize(num_window_words);
+    product = buffer;
+  }
+  multiply_window(seed_, input, first_word, product);
+
+  for (std::size_t i = 0u; i < output.size(); ++i) {
+    output[i] = shift == 0u ? product[i] : product[i] >> shift | product[i + 1u] << (64u - shift);
+  }
+  if (num_output_bits_ % 64u != 0u) {
+    output.back() &= (std::uint64_t(1u) << num_output_bits_ % 64u) - 1u;
+  }
+}
+
+std::vector<unsigned char> ToeplitzExtractor::extract(IsMajsoulFair::Integer const &input) const
+{
+  if (input.bitLength() > num_input_bits_) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1)
+      << input.bitLength() << ": The input must be less than 2^" << num_input_bits_ << '.';
+  }
+
+  std::vector<unsigned char> bytes(8u * getNumWords(num_input_bits_));
+  input.exportBits(bytes.data(), 8u * bytes.size(), IsMajsoulFair::BitOrder::least_significant_first);
+  std::vector<std::uint64_t> words(getNumWords(num_input_bits_));
+  for (std::size_t i = 0u; i < bytes.size(); ++i) {
+    words[i / 8u] |= static_cast<std::uint64_t>(bytes[i]) << (8u * (i % 8u));
+  }
+
+  std::vector<std::uint64_t> output(getNumWords(num_output_bits_));
+  extract(words, output);
+
+  std::vector<unsigned char> result(num_output_bits_);
+  for (std::size_t i = 0u; i < num_output_bits_; ++i) {
+    result[i] = output[i / 64u] >> (i % 64u) & 1u;
+  }
+  return result;
+}
+
+} // namespace IsMajsoulFair
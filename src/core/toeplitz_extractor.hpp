@@ -0,0 +1,61 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_TOEPLITZ_EXTRACTOR_HPP)
+#define CORE_TOEPLITZ_EXTRACTOR_HPP
+
+#include "integer.hpp"
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// A seeded Toeplitz hash from `num_input_bits` bits to `num_output_bits`
+// bits over GF(2), `y = T x`, where `T` is determined by the
+// `num_input_bits + num_output_bits - 1` bits of the seed. Toeplitz hashing
+// is universal, so by the leftover hash lemma, for an input with min-entropy
+// `k`, the output is within statistical distance `2^-((k - m) / 2)` of
+// uniform for `m` output bits. An alternative to `intervalToBinary` that
+// takes no random state per input, and that is applied to, e.g., the lower
+// numerator of the interval or the rank of a paishan.
+//
+// `T x` is a window of the carry-less product of the seed and `x`, so it is
+// computed with PCLMULQDQ where available, and with a portable carry-less
+// multiplication otherwise.
+class ToeplitzExtractor
+{
+public:
+  // Draws the seed from `state`.
+  ToeplitzExtractor(
+    std::size_t num_input_bits, std::size_t num_output_bits, IsMajsoulFair::IntegerRandomState &state);
+
+  // `seed` is `num_input_bits + num_output_bits - 1` bits, least significant
+  // first, in 64-bit words.
+  ToeplitzExtractor(std::size_t num_input_bits, std::size_t num_output_bits, std::vector<std::uint64_t> seed);
+
+  std::size_t getNumInputBits() const noexcept;
+
+  std::size_t getNumOutputBits() const noexcept;
+
+  // `input` is `num_input_bits` bits, least significant first, in 64-bit
+  // words, and so is `output` for `num_output_bits` bits.
+  void extract(std::span<std::uint64_t const> input, std::span<std::uint64_t> output) const;
+
+  // Hashes `input`, which must be less than `2^num_input_bits`, and returns
+  // the output one bit per element, the first output bit first, as
+  // `intervalToBinary` does.
+  std::vector<unsigned char> extract(IsMajsoulFair::Integer const &input) const;
+
+private:
+  std::size_t num_input_bits_;
+  std::size_t num_output_bits_;
+  std::vector<std::uint64_t> seed_;
+}; // class ToeplitzExtractor
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_TOEPLITZ_EXTRACTOR_HPP)
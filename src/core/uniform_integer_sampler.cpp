@@ -0,0 +1,97 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "uniform_integer_sampler.hpp"
+
+#include "integer.hpp"
+#include "../common/throw.hpp"
+#include <array>
+#include <vector>
+#include <stdexcept>
+#include <cstddef>
+#include <gmp.h>
+
+
+namespace IsMajsoulFair{
+
+namespace{
+
+void drawLimbs(
+  IsMajsoulFair::IntegerRandomState &state,
+  std::vector<mp_limb_t> const &upper_limbs,
+  mp_limb_t const top_mask,
+  mp_limb_t * const limbs)
+{
+  std::size_t const num_limbs = upper_limbs.size();
+  mp_limb_t const upper_top = upper_limbs[num_limbs - 1u];
+  while (true) {
+    mp_limb_t const top = state() & top_mask;
+    if (top > upper_top) {
+      continue;
+    }
+    limbs[num_limbs - 1u] = top;
+    state.generate(limbs, limbs + (num_limbs - 1u));
+    if (top < upper_top) {
+      return;
+    }
+    if (num_limbs >= 2u && mpn_cmp(limbs, upper_limbs.data(), num_limbs - 1u) < 0) {
+      return;
+    }
+  }
+}
+
+} // namespace <unnamed>
+
+UniformIntegerSampler::UniformIntegerSampler(IsMajsoulFair::Integer const &upper)
+  : num_bits_(upper.bitLength()),
+    upper_limbs_(),
+    top_mask_()
+{
+  if (upper <= 0ul) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>("`upper` must be positive.");
+  }
+
+  std::size_t const num_limbs = (num_bits_ + GMP_NUMB_BITS - 1u) / GMP_NUMB_BITS;
+  std::vector<unsigned char> bytes(num_limbs * sizeof(mp_limb_t));
+  upper.exportBits(bytes.data(), 8u * bytes.size(), IsMajsoulFair::BitOrder::least_significant_first);
+  upper_limbs_.assign(num_limbs, 0u);
+  for (std::size_t i = 0u; i < bytes.size(); ++i) {
+    upper_limbs_[i / sizeof(mp_limb_t)] |= mp_limb_t(bytes[i]) << (8u * (i % sizeof(mp_limb_t)));
+  }
+
+  std::size_t const num_top_bits = num_bits_ % GMP_NUMB_BITS;
+  top_mask_ = num_top_bits == 0u ? ~mp_limb_t(0u) : (mp_limb_t(1u) << num_top_bits) - 1u;
+}
+
+std::size_t UniformIntegerSampler::getNumBits() const noexcept
+{
+  return num_bits_;
+}
+
+void UniformIntegerSampler::sample(IsMajsoulFair::IntegerRandomState &state, IsMajsoulFair::Integer &result) const
+{
+  if (result.is_small_ && upper_limbs_.size() <= 2u && num_bits_ < 128u) {
+    std::array<mp_limb_t, 2u> limbs{};
+    drawLimbs(state, upper_limbs_, top_mask_, limbs.data());
+    result.storage_.small
+      = static_cast<__int128>(static_cast<unsigned __int128>(limbs[1u]) << 64u | limbs[0u]);
+    return;
+  }
+
+  result.promote_();
+  mp_size_t const num_limbs = upper_limbs_.size();
+  mp_limb_t * const limbs = mpz_limbs_write(result.storage_.big, num_limbs);
+  drawLimbs(state, upper_limbs_, top_mask_, limbs);
+  mpz_limbs_finish(result.storage_.big, num_limbs);
+}
+
+void UniformIntegerSampler::sample(
+  IsMajsoulFair::IntegerRandomState &state, std::vector<IsMajsoulFair::Integer> &results) const
+{
+  for (IsMajsoulFair::Integer &result : results) {
+    sample(state, result);
+  }
+}
+
+} // namespace IsMajsoulFair
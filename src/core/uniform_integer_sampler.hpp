@@ -0,0 +1,40 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#if !defined(CORE_UNIFORM_INTEGER_SAMPLER_HPP)
+#define CORE_UNIFORM_INTEGER_SAMPLER_HPP
+
+#include "integer.hpp"
+#include <gmp.h>
+#include <vector>
+#include <cstddef>
+
+
+namespace IsMajsoulFair{
+
+// Draws integers uniformly from `[0, upper)` for a fixed `upper`. Samples are
+// built limb by limb from `IntegerRandomState::operator()`, most significant
+// limb first, so that a top limb above that of `upper` is rejected before any
+// other limb is drawn.
+class UniformIntegerSampler
+{
+public:
+  explicit UniformIntegerSampler(IsMajsoulFair::Integer const &upper);
+
+  std::size_t getNumBits() const noexcept;
+
+  void sample(IsMajsoulFair::IntegerRandomState &state, IsMajsoulFair::Integer &result) const;
+
+  // Overwrites every element of `results`, reusing the limbs they already own.
+  void sample(IsMajsoulFair::IntegerRandomState &state, std::vector<IsMajsoulFair::Integer> &results) const;
+
+private:
+  std::size_t num_bits_;
+  std::vector<mp_limb_t> upper_limbs_;
+  mp_limb_t top_mask_;
+}; // class UniformIntegerSampler
+
+} // namespace IsMajsoulFair
+
+#endif // !defined(CORE_UNIFORM_INTEGER_SAMPLER_HPP)
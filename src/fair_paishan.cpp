@@ -2,13 +2,22 @@
 // SPDX-License-Identifier: MIT
 // This file is part of https://github.com/Cryolite/is-majsoul-fair.
 
+#include "core/fair_paishan.hpp"
+#include "core/tile_set.hpp"
+#include "core/integer.hpp"
 #include "common/throw.hpp"
 #include <boost/lexical_cast.hpp>
 #include <random>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <algorithm>
+#include <string_view>
 #include <vector>
 #include <array>
+#include <memory>
+#include <functional>
+#include <stdexcept>
 #include <cstdint>
 #include <cstdlib>
 #include <cstddef>
@@ -16,6 +25,8 @@
 
 namespace{
 
+using std::placeholders::_1;
+
 std::mt19937 createRandomNumberEngine()
 {
   std::random_device random_device;
@@ -25,82 +36,79 @@ std::mt19937 createRandomNumberEngine()
   return std::mt19937(seed_sequence);
 }
 
-std::vector<std::uint_fast8_t> createPaishan(std::size_t const num_tiles, std::mt19937 &random_number_engine)
+IsMajsoulFair::IntegerRandomState createIntegerRandomState()
 {
-  std::vector<std::uint_fast8_t> paishan(136u, 0u);
-  std::iota(paishan.begin(), paishan.end(), 0u);
-  std::shuffle(paishan.begin(), paishan.end(), random_number_engine);
-  for (std::uint_fast8_t &tile : paishan) {
-    if (0u <= tile && tile < 16u) {
-      tile /= 4u;
-      tile += 1u;
-      continue;
-    }
-    if (tile == 16u) {
-      tile = 0u;
-      continue;
-    }
-    if (16u < tile && tile < 36u) {
-      tile /= 4u;
-      tile += 1u;
-      continue;
-    }
-    if (36u <= tile && tile < 52u) {
-      tile /= 4u;
-      tile += 2u;
-      continue;
-    }
-    if (tile == 52u) {
-      tile = 10u;
-      continue;
-    }
-    if (52u < tile && tile < 72u) {
-      tile /= 4u;
-      tile += 2u;
-      continue;
-    }
-    if (72u <= tile && tile < 88u) {
-      tile /= 4u;
-      tile += 3u;
-      continue;
-    }
-    if (tile == 88u) {
-      tile = 20u;
-      continue;
-    }
-    if (88u < tile) {
-      tile /= 4u;
-      tile += 3u;
-      continue;
+  std::random_device random_device;
+  std::array<std::uint64_t, 2u> seed;
+  for (std::uint64_t &word : seed) {
+    word = std::uint64_t(random_device()) << 32u | random_device();
+  }
+  return IsMajsoulFair::IntegerRandomState(seed);
+}
+
+template<typename TileSet>
+std::function<std::vector<std::uint_fast8_t>()> createGenerator(
+  std::uint_fast8_t const num_tiles, std::string_view const mode, char const * const bitstream_path)
+{
+  if (mode == "shuffle") {
+    return [num_tiles, random_number_engine = createRandomNumberEngine()]() mutable {
+      return IsMajsoulFair::generateFairPaishan<TileSet>(random_number_engine, num_tiles);
+    };
+  }
+  if (bitstream_path != nullptr) {
+    std::filesystem::path const path(bitstream_path);
+    auto bitstream = std::make_shared<std::ifstream>(path, std::ios_base::in | std::ios_base::binary);
+    if (!*bitstream) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to open.";
     }
-    IS_MAJSOUL_FAIR_THROW<std::logic_error>("A logic error.");
+    return [num_tiles, bitstream]() {
+      return IsMajsoulFair::generateFairPaishan<TileSet>(*bitstream, num_tiles);
+    };
   }
-  paishan.resize(num_tiles);
-  return paishan;
+  // `std::function` requires a copyable target.
+  auto state = std::make_shared<IsMajsoulFair::IntegerRandomState>(createIntegerRandomState());
+  return [num_tiles, state]() {
+    return IsMajsoulFair::generateFairPaishan<TileSet>(*state, num_tiles);
+  };
 }
 
 } // namespace <unnamed>
 
 int main(int const argc, char const * const * const argv)
 {
-  if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " <83|136> <# of paishan>" << std::endl;
+  if (argc < 3 || 5 < argc || (argc == 5 && std::string_view(argv[3u]) != "unrank")) {
+    std::cerr << "Usage: " << argv[0] << " <68|83|108|136> <# of paishan> [shuffle|unrank [<path to bitstream>]]"
+              << std::endl;
     return EXIT_FAILURE;
   }
 
   std::size_t const num_tiles = boost::lexical_cast<std::size_t>(argv[1u]);
-  if (num_tiles != 83u && num_tiles != 136u) {
-    std::cerr << "The first argument must be either `83` or `136`, but it is `"
+  bool const is_four_player = num_tiles == IsMajsoulFair::FourPlayerTileSet::num_partial_tiles
+    || num_tiles == IsMajsoulFair::FourPlayerTileSet::num_tiles;
+  bool const is_three_player = num_tiles == IsMajsoulFair::ThreePlayerTileSet::num_partial_tiles
+    || num_tiles == IsMajsoulFair::ThreePlayerTileSet::num_tiles;
+  if (!is_four_player && !is_three_player) {
+    std::cerr << "The first argument must be one of `68`, `83`, `108` and `136`, but it is `"
       << num_tiles << "`." << std::endl;
     return EXIT_FAILURE;
   }
 
   std::size_t const num_paishan = boost::lexical_cast<std::size_t>(argv[2u]);
 
-  std::mt19937 random_number_engine = createRandomNumberEngine();
+  std::string_view const mode = argc >= 4 ? argv[3u] : "shuffle";
+  if (mode != "shuffle" && mode != "unrank") {
+    std::cerr << "The third argument must be either `shuffle` or `unrank`, but it is `"
+      << mode << "`." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  char const * const bitstream_path = argc == 5 ? argv[4u] : nullptr;
+  std::function<std::vector<std::uint_fast8_t>()> const generate = is_four_player
+    ? createGenerator<IsMajsoulFair::FourPlayerTileSet>(num_tiles, mode, bitstream_path)
+    : createGenerator<IsMajsoulFair::ThreePlayerTileSet>(num_tiles, mode, bitstream_path);
 
   for (std::size_t i = 0u; i < num_paishan; ++i) {
-    std::vector<std::uint_fast8_t> const paishan = createPaishan(num_tiles, random_number_engine);
+    std::vector<std::uint_fast8_t> const paishan = generate();
     bool is_first = true;
     for (std::uint_fast8_t const tile : paishan) {
       if (!is_first) {
@@ -0,0 +1,118 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "core/integer.hpp"
+#include <boost/lexical_cast.hpp>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstdlib>
+#include <cstddef>
+#include <gmp.h>
+
+
+namespace{
+
+// Counts the allocations that GMP makes, and forwards them to the functions
+// that were installed before.
+std::atomic_size_t num_gmp_allocations(0u);
+
+void *(*base_allocate)(std::size_t) = nullptr;
+
+void *(*base_reallocate)(void *, std::size_t, std::size_t) = nullptr;
+
+void (*base_free)(void *, std::size_t) = nullptr;
+
+void *allocateCounting(std::size_t const size)
+{
+  num_gmp_allocations.fetch_add(1u, std::memory_order_relaxed);
+  return base_allocate(size);
+}
+
+void *reallocateCounting(void * const p, std::size_t const old_size, std::size_t const new_size)
+{
+  num_gmp_allocations.fetch_add(1u, std::memory_order_relaxed);
+  return base_reallocate(p, old_size, new_size);
+}
+
+void installCountingGmpAllocator()
+{
+  mp_get_memory_functions(&base_allocate, &base_reallocate, &base_free);
+  mp_set_memory_functions(&allocateCounting, &reallocateCounting, base_free);
+}
+
+// Keeps the results alive so that the loops are not optimized away.
+std::size_t sink = 0u;
+
+// Runs `f` on every pair of adjacent operands `num_iterations` times over,
+// and prints nanoseconds and GMP allocations per call.
+template<typename F>
+void measure(
+  std::string_view const name,
+  std::vector<IsMajsoulFair::Integer> const &operands,
+  std::size_t const num_iterations,
+  F &&f)
+{
+  std::size_t const num_allocations = num_gmp_allocations.load();
+  auto const start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0u; i < num_iterations; ++i) {
+    std::size_t const j = i % (operands.size() - 1u);
+    sink += f(operands[j], operands[j + 1u]).bitLength();
+  }
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "  " << name << ", " << elapsed.count() / num_iterations * 1.0e9 << ", "
+            << static_cast<double>(num_gmp_allocations.load() - num_allocations) / num_iterations << std::endl;
+}
+
+void measureAll(std::string_view const name, std::vector<IsMajsoulFair::Integer> const &operands, std::size_t const n)
+{
+  std::cout << name << ':' << std::endl;
+  std::cout << "  operation, nanoseconds, GMP allocations" << std::endl;
+  measure("operator+", operands, n, [](IsMajsoulFair::Integer const &x, IsMajsoulFair::Integer const &y) {
+    return x + y;
+  });
+  measure("operator*", operands, n, [](IsMajsoulFair::Integer const &x, IsMajsoulFair::Integer const &y) {
+    return x * y;
+  });
+  measure("operator*(unsigned long)", operands, n, [](IsMajsoulFair::Integer const &x, IsMajsoulFair::Integer const &) {
+    return x * 136ul;
+  });
+  measure("copy", operands, n, [](IsMajsoulFair::Integer const &x, IsMajsoulFair::Integer const &) {
+    return IsMajsoulFair::Integer(x);
+  });
+}
+
+} // namespace <unnamed>
+
+int main(int const argc, char const * const * const argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [<# OF ITERATIONS>]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::size_t const num_iterations = argc == 2 ? boost::lexical_cast<std::size_t>(argv[1]) : 10000000u;
+
+  installCountingGmpAllocator();
+
+  // Values that stay on the inline fast path, and ones about the size of the
+  // denominator of a 136-tile wall.
+  std::vector<IsMajsoulFair::Integer> small;
+  std::vector<IsMajsoulFair::Integer> large;
+  IsMajsoulFair::Integer factorial(1ul);
+  for (unsigned long i = 1u; i <= 136u; ++i) {
+    factorial *= i;
+  }
+  for (unsigned long i = 1u; i <= 64u; ++i) {
+    small.emplace_back(i * 0x9E3779B9ul);
+    large.push_back(factorial + i);
+  }
+
+  measureAll("Small values (< 2^40)", small, num_iterations);
+  measureAll("136!", large, num_iterations);
+
+  return sink == 0u ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,12 +1,15 @@
 #include "../core/paishan_reader.hpp"
+#include "../core/parallel_paishan_corpus_reader.hpp"
+#include "../core/tile_set.hpp"
 #include "../common/throw.hpp"
 #include <boost/math/distributions/chi_squared.hpp>
 #include <boost/lexical_cast.hpp>
 #include <mutex>
 #include <thread>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
+#include <span>
+#include <vector>
 #include <functional>
 #include <stdexcept>
 #include <cstdint>
@@ -19,63 +22,57 @@ using std::placeholders::_1;
 
 std::mutex mtx;
 
-void test(
+// Reads the first `num_samples` paishan once, back to back, so that the tests
+// on every position share a single pass over the file.
+template<typename TileSet>
+std::vector<std::uint8_t> readSamples(
   unsigned long const num_tiles,
   std::filesystem::path const &path_to_paishans_file,
-  std::uint_fast8_t const position0,
-  std::uint_fast8_t const position1,
   unsigned long const num_samples)
 {
-  std::ifstream ifs(path_to_paishans_file);
-  if (!ifs) {
-    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path_to_paishans_file << ": Failed to open the file.";
+  IsMajsoulFair::ParallelPaishanCorpusReader reader(path_to_paishans_file, 0u);
+
+  std::vector<std::uint8_t> samples;
+  samples.reserve(num_tiles * num_samples);
+  IsMajsoulFair::PaishanChunk chunk;
+  while (samples.size() < num_tiles * num_samples) {
+    if (!reader.next(chunk)) {
+      IS_MAJSOUL_FAIR_THROW<std::runtime_error>("Unexpectedly reached the end of the file.");
+    }
+    for (std::size_t i = 0u; i < chunk.getNumPaishan() && samples.size() < num_tiles * num_samples; ++i) {
+      std::span<std::uint8_t const> const paishan = chunk.getPaishan(i);
+      if (paishan.size() != num_tiles) {
+        IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << paishan.size() << ": An unexpected number of tiles.";
+      }
+      IsMajsoulFair::checkPaishan<TileSet>(paishan);
+      samples.insert(samples.end(), paishan.begin(), paishan.end());
+    }
   }
+  return samples;
+}
 
+template<typename TileSet>
+void test(
+  unsigned long const num_tiles,
+  std::span<std::uint8_t const> const samples,
+  std::uint_fast8_t const position0,
+  std::uint_fast8_t const position1,
+  unsigned long const num_samples)
+{
   std::array<double, 37u * 37u> expected;
-  expected.fill(num_samples / (136.0 * 135.0));
+  expected.fill(num_samples / (static_cast<double>(TileSet::num_tiles) * (TileSet::num_tiles - 1u)));
   for (std::uint_fast8_t i = 0u; i < 37u; ++i) {
-    double const multiplier0 = [&]() {
-      switch (i) {
-      case 0u:
-      case 10u:
-      case 20u:
-        return 1.0;
-      case 5u:
-      case 15u:
-      case 25u:
-        return 3.0;
-      default:
-        return 4.0;
-      }
-      IS_MAJSOUL_FAIR_THROW<std::logic_error>("The control flow should not reach here.");
-    }();
-
+    double const multiplier0 = TileSet::num_tiles_per_code[i];
     for (std::uint_fast8_t j = 0u; j < 37u; ++j) {
-      double const multiplier = [&]() {
-        if (i == j) {
-          return multiplier0 * (multiplier0 - 1.0);
-        }
-        switch (j) {
-        case 0u:
-        case 10u:
-        case 20u:
-          return multiplier0 * 1.0;
-        case 5u:
-        case 15u:
-        case 25u:
-          return multiplier0 * 3.0;
-        default:
-          return multiplier0 * 4.0;
-        }
-        IS_MAJSOUL_FAIR_THROW<std::logic_error>("The control flow should not reach here.");
-      }();
+      double const multiplier = i == j
+        ? multiplier0 * (multiplier0 - 1.0) : multiplier0 * TileSet::num_tiles_per_code[j];
       expected[i * 37u + j] *= multiplier;
     }
   }
 
   std::vector<unsigned long> counts(37u * 37u, 0u);
   for (unsigned long i = 0u; i < num_samples; ++i) {
-    std::vector<std::uint_fast8_t> paishan = IsMajsoulFair::readPaishan(num_tiles, ifs);
+    std::span<std::uint8_t const> const paishan = samples.subspan(num_tiles * i, num_tiles);
     std::uint_fast8_t const tile0 = paishan[position0];
     std::uint_fast8_t const tile1 = paishan[position1];
     ++counts[tile0 * 37u + tile1];
@@ -93,7 +90,7 @@ void test(
     }
   }
 
-  double const degrees_of_freedom = static_cast<double>(37u * 37u - 1u);
+  double const degrees_of_freedom = static_cast<double>(TileSet::num_codes * TileSet::num_codes - 1u);
   boost::math::chi_squared_distribution<> chi_square_distribution(degrees_of_freedom);
   double const p_value = 1.0 - boost::math::cdf(chi_square_distribution, chi_square);
 
@@ -103,9 +100,10 @@ void test(
   }
 }
 
+template<typename TileSet>
 void testThreadMain(
   std::uint_fast8_t const num_tiles,
-  std::filesystem::path const &path_to_paishans_file,
+  std::span<std::uint8_t const> const samples,
   unsigned long const num_samples,
   unsigned const concurrency,
   unsigned const thread_index)
@@ -116,7 +114,7 @@ void testThreadMain(
       if (position_pair_encode % concurrency != thread_index) {
         continue;
       }
-      test(num_tiles, path_to_paishans_file, i, j, num_samples);
+      test<TileSet>(num_tiles, samples, i, j, num_samples);
     }
   }
 }
@@ -126,13 +124,17 @@ void testThreadMain(
 int main(int const argc, char const * const * const argv)
 {
   if (argc != 4) {
-    std::cerr << "Usage: " << argv[0] << " <83 or 136> <path_to_paishans_file> <num_samples>" << std::endl;
+    std::cerr << "Usage: " << argv[0] << " <68, 83, 108 or 136> <path_to_paishans_file> <num_samples>" << std::endl;
     return EXIT_FAILURE;
   }
 
   unsigned long const num_tiles = boost::lexical_cast<unsigned long>(argv[1]);
-  if (num_tiles != 83 && num_tiles != 136) {
-    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << num_tiles << ": The number of tiles must be 83 or 136.";
+  bool const is_four_player = num_tiles == IsMajsoulFair::FourPlayerTileSet::num_partial_tiles
+    || num_tiles == IsMajsoulFair::FourPlayerTileSet::num_tiles;
+  bool const is_three_player = num_tiles == IsMajsoulFair::ThreePlayerTileSet::num_partial_tiles
+    || num_tiles == IsMajsoulFair::ThreePlayerTileSet::num_tiles;
+  if (!is_four_player && !is_three_player) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << num_tiles << ": The number of tiles must be 68, 83, 108 or 136.";
   }
 
   std::filesystem::path const path_to_paishans_file(argv[2]);
@@ -148,13 +150,17 @@ int main(int const argc, char const * const * const argv)
     IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << num_samples << ": The number of samples must be greater than 0.";
   }
 
+  std::vector<std::uint8_t> const samples = is_four_player
+    ? readSamples<IsMajsoulFair::FourPlayerTileSet>(num_tiles, path_to_paishans_file, num_samples)
+    : readSamples<IsMajsoulFair::ThreePlayerTileSet>(num_tiles, path_to_paishans_file, num_samples);
+
   unsigned const concurrency = std::thread::hardware_concurrency();
   std::vector<std::thread> threads;
   for (unsigned i = 0u; i < concurrency; ++i) {
     threads.emplace_back(
-      testThreadMain,
+      is_four_player ? testThreadMain<IsMajsoulFair::FourPlayerTileSet> : testThreadMain<IsMajsoulFair::ThreePlayerTileSet>,
       num_tiles,
-      path_to_paishans_file,
+      std::span<std::uint8_t const>(samples),
       num_samples,
       concurrency,
       i);
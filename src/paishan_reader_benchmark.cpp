@@ -0,0 +1,199 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "core/parallel_paishan_corpus_reader.hpp"
+#include "core/binary_paishan_corpus.hpp"
+#include "core/memory_mapped_file.hpp"
+#include "core/paishan_corpus_reader.hpp"
+#include "core/paishan_reader.hpp"
+#include "common/throw.hpp"
+#include <boost/lexical_cast.hpp>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <string>
+#include <thread>
+#include <vector>
+#include <array>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+// The number of the paishan and a checksum of their tiles, so that the
+// parsers can be checked against each other. The checksum is a sum over the
+// paishan, so that it does not depend on the order they are read in.
+struct Result
+{
+  std::size_t num_paishan;
+  std::uint64_t checksum;
+}; // struct Result
+
+std::uint64_t hashTile(std::uint64_t const hash, std::uint64_t const tile)
+{
+  return hash * 37u + tile;
+}
+
+void accumulate(Result &result, std::uint64_t const hash)
+{
+  result.checksum += hash * 0x9E3779B97F4A7C15u;
+  ++result.num_paishan;
+}
+
+// `std::getline`, `std::ranges::views::split` and `boost::lexical_cast`, as
+// the tools used to parse a corpus.
+Result parseByGetline(std::filesystem::path const &path)
+{
+  std::ifstream ifs(path);
+  if (!ifs) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to open.";
+  }
+  Result result{0u, 0u};
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::uint64_t hash = 0u;
+    for (auto e : line | std::ranges::views::split(',')) {
+      std::string_view sv{e.begin(), e.end()};
+      hash = hashTile(hash, boost::lexical_cast<unsigned long>(sv));
+    }
+    accumulate(result, hash);
+  }
+  return result;
+}
+
+// `readPaishan`, which needs every paishan to be of the same length.
+Result parseByIstream(std::filesystem::path const &path, std::size_t const length)
+{
+  std::ifstream ifs(path);
+  if (!ifs) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to open.";
+  }
+  Result result{0u, 0u};
+  while ((ifs >> std::ws).peek() != std::ifstream::traits_type::eof()) {
+    std::uint64_t hash = 0u;
+    for (std::uint_fast8_t const tile : IsMajsoulFair::readPaishan(length, ifs)) {
+      hash = hashTile(hash, tile);
+    }
+    accumulate(result, hash);
+  }
+  return result;
+}
+
+Result parseByMapping(std::filesystem::path const &path)
+{
+  IsMajsoulFair::PaishanCorpusReader reader(path);
+  Result result{0u, 0u};
+  while (true) {
+    std::span<std::uint8_t const> const paishan = reader.next();
+    if (paishan.empty()) {
+      break;
+    }
+    std::uint64_t hash = 0u;
+    for (std::uint8_t const tile : paishan) {
+      hash = hashTile(hash, tile);
+    }
+    accumulate(result, hash);
+  }
+  return result;
+}
+
+Result parseInParallel(
+  std::filesystem::path const &path, std::size_t const num_threads, IsMajsoulFair::PaishanChunkOrder const order)
+{
+  IsMajsoulFair::ParallelPaishanCorpusReader reader(path, num_threads, order);
+  Result result{0u, 0u};
+  IsMajsoulFair::PaishanChunk chunk;
+  while (reader.next(chunk)) {
+    for (std::size_t i = 0u; i < chunk.getNumPaishan(); ++i) {
+      std::uint64_t hash = 0u;
+      for (std::uint8_t const tile : chunk.getPaishan(i)) {
+        hash = hashTile(hash, tile);
+      }
+      accumulate(result, hash);
+    }
+  }
+  return result;
+}
+
+template<typename F>
+void measure(std::string_view const name, std::uintmax_t const num_bytes, F &&f)
+{
+  auto const start = std::chrono::steady_clock::now();
+  Result const result = f();
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << name << ": " << result.num_paishan << " paishan, checksum " << std::hex << result.checksum
+            << std::dec << ", " << elapsed.count() << " s, " << num_bytes / elapsed.count() / 1.0e6 << " MB/s"
+            << std::endl;
+}
+
+} // namespace <unnamed>
+
+int main(int const argc, char const * const * const argv)
+{
+  if (argc != 2 && argc != 3) {
+    std::cerr << "Usage: " << argv[0] << " <PATH TO PAISHAN FILE> [<# OF THREADS>]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::size_t const num_threads = [&]() -> std::size_t {
+    if (argc == 3) {
+      std::size_t const num_threads = boost::lexical_cast<std::size_t>(argv[2]);
+      if (num_threads == 0u) {
+        return std::thread::hardware_concurrency();
+      }
+      return num_threads;
+    }
+    return std::thread::hardware_concurrency();
+  }();
+
+  std::filesystem::path const path(argv[1]);
+  std::uintmax_t const num_bytes = std::filesystem::file_size(path);
+  bool const binary = IsMajsoulFair::isBinaryPaishanCorpus(IsMajsoulFair::MemoryMappedFile(path).getBytes());
+
+  // `readPaishan` is only measured on a corpus of one length.
+  std::size_t length = 0u;
+  bool uniform = true;
+  {
+    IsMajsoulFair::PaishanCorpusReader reader(path);
+    length = reader.next().size();
+    while (true) {
+      std::size_t const size = reader.next().size();
+      if (size == 0u) {
+        break;
+      }
+      uniform = uniform && size == length;
+    }
+  }
+
+  measure("mmap", num_bytes, [&]() { return parseByMapping(path); });
+  for (std::size_t n = 1u; n <= num_threads; n *= 2u) {
+    std::string const threads = " (" + std::to_string(n) + (n == 1u ? " thread)" : " threads)");
+    measure("mmap, ordered" + threads, num_bytes, [&]() {
+      return parseInParallel(path, n, IsMajsoulFair::PaishanChunkOrder::ordered);
+    });
+    measure("mmap, unordered" + threads, num_bytes, [&]() {
+      return parseInParallel(path, n, IsMajsoulFair::PaishanChunkOrder::unordered);
+    });
+  }
+  // The text baselines cannot parse a binary corpus.
+  if (binary) {
+    return EXIT_SUCCESS;
+  }
+  measure("getline", num_bytes, [&]() { return parseByGetline(path); });
+  if (uniform && length != 0u) {
+    measure("istream", num_bytes, [&]() { return parseByIstream(path, length); });
+  }
+}
@@ -3,33 +3,70 @@
 // This file is part of https://github.com/Cryolite/is-majsoul-fair.
 
 #include "core/interval_to_binary.hpp"
-#include "core/permutation_to_interval.hpp"
+#include "core/covering_binary_interval.hpp"
+#include "core/range_decoder.hpp"
+#include "core/concatenated_extractor.hpp"
+#include "core/toeplitz_extractor.hpp"
+#include "core/permutation_to_interval_batch.hpp"
+#include "core/paishan_coding_context.hpp"
+#include "core/paishan_corpus_reader.hpp"
+#include "core/tile_set.hpp"
 #include "core/interval.hpp"
 #include "core/integer.hpp"
+#include "core/gmp_arena.hpp"
 #include "common/throw.hpp"
 #include <boost/lexical_cast.hpp>
-#include <filesystem>
-#include <fstream>
 #include <iostream>
-#include <ranges>
+#include <optional>
+#include <span>
 #include <string_view>
-#include <string>
+#include <vector>
+#include <array>
+#include <stdexcept>
 #include <functional>
 #include <cstdint>
 #include <cstdlib>
+#include <cstddef>
 
 
 namespace{
 
 using std::placeholders::_1;
 
-void paishanToBinary(
-  std::vector<unsigned char> const &paishan,
-  std::size_t const num_bits,
-  IsMajsoulFair::IntegerRandomState &state)
+constexpr std::size_t batch_size = 1024u;
+
+// The number of the paishan per block in `concatenated` mode.
+constexpr std::size_t concatenated_block_size = 64u;
+
+std::array<std::uint64_t, 2u> parseSeed(std::string_view const hex)
+{
+  if (hex.empty() || hex.size() > 32u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << hex << ": An invalid seed.";
+  }
+  std::uint64_t high = 0u;
+  std::uint64_t low = 0u;
+  for (char const c : hex) {
+    std::uint64_t digit;
+    if ('0' <= c && c <= '9') {
+      digit = c - '0';
+    }
+    else if ('a' <= c && c <= 'f') {
+      digit = c - 'a' + 10;
+    }
+    else if ('A' <= c && c <= 'F') {
+      digit = c - 'A' + 10;
+    }
+    else {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << hex << ": An invalid seed.";
+    }
+    high = high << 4u | low >> 60u;
+    low = low << 4u | digit;
+  }
+  return {low, high};
+}
+
+void writeBinary(std::vector<unsigned char> const &binary)
 {
-  IsMajsoulFair::Interval const interval = IsMajsoulFair::permutationToInterval(paishan);
-  std::vector<unsigned char> const binary = IsMajsoulFair::intervalToBinary(interval, num_bits, state);
   if (binary.size() % 8u != 0u) {
     IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << binary.size();
   }
@@ -47,25 +84,176 @@ void paishanToBinary(
   std::cout << std::flush;
 }
 
+// Writes the whole bytes of `bits`, and leaves the rest of them in it.
+void writeWholeBytes(std::vector<unsigned char> &bits)
+{
+  std::size_t const num_bits = bits.size() - bits.size() % 8u;
+  std::vector<unsigned char> rest(bits.cbegin() + num_bits, bits.cend());
+  bits.resize(num_bits);
+  writeBinary(bits);
+  bits.swap(rest);
+}
+
+// Writes a record of `adaptive` mode: the number of the bits as a 16-bit
+// big-endian integer, followed by the bits packed most significant first, the
+// last byte padded with zeros.
+void writeFramedBinary(std::vector<unsigned char> const &binary)
+{
+  if (binary.size() > UINT16_MAX) {
+    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << binary.size();
+  }
+  std::cout << static_cast<std::uint8_t>(binary.size() >> 8u) << static_cast<std::uint8_t>(binary.size());
+  for (std::size_t i = 0u; i < binary.size(); i += 8u) {
+    std::uint8_t byte = 0u;
+    for (std::size_t j = 0u; j < 8u; ++j) {
+      byte = byte << 1u | (i + j < binary.size() ? binary[i + j] : 0u);
+    }
+    std::cout << byte;
+  }
+  std::cout << std::flush;
+}
+
+void paishanToBinary(
+  std::vector<std::uint8_t> const &tiles,
+  std::vector<std::uint8_t> const &lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals,
+  std::array<IsMajsoulFair::PaishanCodingContext, 2u> const &contexts,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  std::span<std::uint8_t const> const rows(
+    tiles.data(), IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size());
+  // `intervals` outlives the frame, so it must be filled outside of it.
+  IsMajsoulFair::permutationToIntervalBatch(rows, lengths, intervals);
+
+  IsMajsoulFair::GmpArenaFrame const frame;
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    IsMajsoulFair::PaishanCodingContext const &context
+      = lengths[i] == contexts.front().getLength() ? contexts.front() : contexts.back();
+    writeBinary(IsMajsoulFair::intervalToBinary(intervals[i], context, state));
+  }
+}
+
+// Extracts from every paishan the largest number of the bits whose covering
+// binary interval consists of at most two words, so that the bits are drawn
+// from two candidates at most and nearly all the information of the paishan
+// is kept. The number depends on the paishan, so it is written in front of
+// the bits. Since the number is a function of the paishan, the bits of a
+// record are not uniform given their number; only the leading bits up to the
+// minimum number over the corpus are.
+void paishanToFramedBinary(
+  std::vector<std::uint8_t> const &tiles,
+  std::vector<std::uint8_t> const &lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  std::span<std::uint8_t const> const rows(
+    tiles.data(), IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size());
+  // `intervals` outlives the frame, so it must be filled outside of it.
+  IsMajsoulFair::permutationToIntervalBatch(rows, lengths, intervals);
+
+  IsMajsoulFair::GmpArenaFrame const frame;
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    std::size_t const num_bits = IsMajsoulFair::getMaxNumBitsWithinTwoWords(intervals[i]);
+    writeFramedBinary(IsMajsoulFair::intervalToBinary(intervals[i], num_bits, state));
+  }
+}
+
+// Hashes the lower numerator of the interval of every paishan with
+// `extractor`. No random state is drawn per paishan.
+void paishanToBinary(
+  std::vector<std::uint8_t> const &tiles,
+  std::vector<std::uint8_t> const &lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals,
+  IsMajsoulFair::ToeplitzExtractor const &extractor)
+{
+  std::span<std::uint8_t const> const rows(
+    tiles.data(), IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size());
+  IsMajsoulFair::permutationToIntervalBatch(rows, lengths, intervals);
+
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    writeBinary(extractor.extract(intervals[i].getLowerNumerator()));
+  }
+}
+
+// Extracts the bits of all the paishan as one number with
+// `ConcatenatedExtractor`, and writes them as a raw bit stream. The bits left
+// over a whole byte are carried to the next batch.
+void paishanToBinary(
+  std::vector<std::uint8_t> const &tiles,
+  std::vector<std::uint8_t> const &lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals,
+  IsMajsoulFair::ConcatenatedExtractor &extractor,
+  std::vector<unsigned char> &bits,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  std::span<std::uint8_t const> const rows(
+    tiles.data(), IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size());
+  IsMajsoulFair::permutationToIntervalBatch(rows, lengths, intervals);
+
+  // The running interval of `extractor` outlives any frame, so no frame is
+  // used here.
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    extractor.push(intervals[i], state);
+  }
+  extractor.takeBits(bits);
+  writeWholeBytes(bits);
+}
+
+void paishanToBinary(
+  std::vector<std::uint8_t> const &tiles,
+  std::vector<std::uint8_t> const &lengths,
+  IsMajsoulFair::RangeDecoder &decoder,
+  IsMajsoulFair::IntegerRandomState &state)
+{
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    std::uint8_t const * const row = tiles.data() + IsMajsoulFair::permutation_to_interval_batch_stride * i;
+    for (std::size_t j = 0u; j < lengths[i]; ++j) {
+      decoder.push(row[j]);
+    }
+    writeBinary(decoder.finish(state));
+  }
+}
+
 } // namespace <unnamed>
 
 int main(int const argc, char const * const * const argv)
 {
-  if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " <PATH TO PAISHAN FILE> <# OF BITS PER PAISHAN>" << std::endl;
+  if (argc < 3 || 5 < argc) {
+    std::cerr << "Usage: " << argv[0]
+              << " <PATH TO PAISHAN FILE> <# OF BITS PER PAISHAN | adaptive | concatenated> [<128-BIT SEED IN HEX> [exact|range|toeplitz]]"
+              << std::endl;
     return EXIT_FAILURE;
   }
 
-  IsMajsoulFair::IntegerRandomState state;
+  // `range` extracts the bits with `RangeDecoder` in fixed precision, whose
+  // output distribution differs slightly from that of the exact path.
+  // `toeplitz` hashes every paishan with `ToeplitzExtractor` seeded once by
+  // the seed, and is close to uniform only while the number of the bits stays
+  // well below the min-entropy of a paishan.
+  std::string_view const mode = argc == 5 ? argv[4] : "exact";
+  if (mode != "exact" && mode != "range" && mode != "toeplitz") {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << mode << ": An invalid mode.";
+  }
 
-  std::filesystem::path const path(argv[1]);
-  std::ifstream ifs(path);
-  if (!ifs) {
-    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to open.";
+  // `adaptive` chooses the number of the bits per paishan, and writes every
+  // paishan as a record of the number followed by the bits.
+  bool const adaptive = std::string_view(argv[2]) == "adaptive";
+  // `concatenated` extracts the bits of the whole file as one number, and
+  // writes them as a raw bit stream. The last bits short of a byte are dropped.
+  bool const concatenated = std::string_view(argv[2]) == "concatenated";
+  if ((adaptive || concatenated) && mode != "exact") {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << argv[2] << ": Only supported in `exact` mode.";
   }
 
-  long long const num_bits = boost::lexical_cast<long long>(argv[2]);
-  if (num_bits <= 0) {
+  IsMajsoulFair::installGmpArena();
+
+  IsMajsoulFair::IntegerRandomState state = argc >= 4
+    ? IsMajsoulFair::IntegerRandomState(parseSeed(argv[3])) : IsMajsoulFair::IntegerRandomState();
+
+  IsMajsoulFair::PaishanCorpusReader reader(argv[1]);
+
+  long long const num_bits = adaptive || concatenated ? 0 : boost::lexical_cast<long long>(argv[2]);
+  if (!adaptive && !concatenated && num_bits <= 0) {
     IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << num_bits << ": An invalid number of bits.";
   }
   if (num_bits % 8 != 0) {
@@ -73,35 +261,63 @@ int main(int const argc, char const * const * const argv)
       << num_bits << ": The number of bits must be a multiple of 8.";
   }
 
-  while (true) {
-    std::string line;
-    std::getline(ifs, line);
-    if (ifs.bad()) {
-      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to read.";
+  std::vector<std::uint8_t> tiles(batch_size * IsMajsoulFair::permutation_to_interval_batch_stride);
+  std::vector<std::uint8_t> lengths;
+  lengths.reserve(batch_size);
+  std::vector<IsMajsoulFair::Interval> intervals;
+  // The contexts outlive every frame, so they must be built outside of them.
+  std::array<IsMajsoulFair::PaishanCodingContext, 2u> const contexts{
+    IsMajsoulFair::PaishanCodingContext(
+      IsMajsoulFair::FourPlayerTileSet(), IsMajsoulFair::FourPlayerTileSet::num_partial_tiles, num_bits),
+    IsMajsoulFair::PaishanCodingContext(
+      IsMajsoulFair::FourPlayerTileSet(), IsMajsoulFair::FourPlayerTileSet::num_tiles, num_bits)};
+  IsMajsoulFair::RangeDecoder decoder(
+    IsMajsoulFair::FourPlayerTileSet::num_tiles_per_code, num_bits, IsMajsoulFair::RangeDecoderMode::fixed_precision);
+  IsMajsoulFair::ConcatenatedExtractor extractor(concatenated_block_size);
+  std::vector<unsigned char> bits;
+  // The input is the lower numerator, which is less than the denominator of a
+  // full wall for either length.
+  std::optional<IsMajsoulFair::ToeplitzExtractor> toeplitz_extractor;
+  if (mode == "toeplitz") {
+    toeplitz_extractor.emplace(contexts.back().getDenominator().bitLength(), num_bits, state);
+  }
+  auto const flush = [&]() {
+    if (toeplitz_extractor) {
+      paishanToBinary(tiles, lengths, intervals, *toeplitz_extractor);
     }
-
-    if (!line.empty()) {
-      std::vector<unsigned char> paishan;
-      for (auto e : line | std::ranges::views::split(',')) {
-        std::string_view sv{e.cbegin(), e.cend()};
-        unsigned long const tile = boost::lexical_cast<unsigned long>(sv);
-        if (tile >= 37u) {
-          IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << static_cast<unsigned>(tile);
-        }
-        paishan.push_back(tile);
-      }
-      if (paishan.size() != 83u && paishan.size() != 136u) {
-        IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << paishan.size();
-      }
-
-      paishanToBinary(paishan, num_bits, state);
-      continue;
+    else if (concatenated) {
+      paishanToBinary(tiles, lengths, intervals, extractor, bits, state);
     }
-
-    if (ifs.eof()) {
+    else if (adaptive) {
+      paishanToFramedBinary(tiles, lengths, intervals, state);
+    }
+    else if (mode == "range") {
+      paishanToBinary(tiles, lengths, decoder, state);
+    }
+    else {
+      paishanToBinary(tiles, lengths, intervals, contexts, state);
+    }
+  };
+  while (true) {
+    std::uint8_t * const row = tiles.data() + IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size();
+    std::size_t const length
+      = reader.read(std::span<std::uint8_t>(row, IsMajsoulFair::permutation_to_interval_batch_stride));
+    if (length == 0u) {
+      flush();
+      if (concatenated) {
+        extractor.finish(state);
+        extractor.takeBits(bits);
+        writeWholeBytes(bits);
+      }
       break;
     }
-
-    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to read.";
+    if (length != 83u && length != 136u) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << length;
+    }
+    lengths.push_back(length);
+    if (lengths.size() == batch_size) {
+      flush();
+      lengths.clear();
+    }
   }
 }
@@ -3,84 +3,139 @@
 // This file is part of https://github.com/Cryolite/is-majsoul-fair.
 
 #include "core/interval_to_entropy.hpp"
-#include "core/permutation_to_interval.hpp"
+#include "core/permutation_to_interval_batch.hpp"
+#include "core/paishan_coding_context.hpp"
+#include "core/parallel_paishan_corpus_reader.hpp"
+#include "core/tile_set.hpp"
 #include "core/interval.hpp"
 #include "core/integer.hpp"
+#include "core/gmp_arena.hpp"
 #include "common/throw.hpp"
 #include <boost/lexical_cast.hpp>
-#include <filesystem>
-#include <fstream>
+#include <algorithm>
 #include <iostream>
-#include <ranges>
+#include <span>
 #include <string_view>
-#include <string>
+#include <vector>
+#include <array>
 #include <functional>
 #include <stdexcept>
 #include <cstdint>
 #include <cstdlib>
+#include <cstddef>
 
 
 namespace{
 
 using std::placeholders::_1;
 
-double paishanToEntropy(std::vector<std::uint_fast8_t> const &paishan, std::size_t const num_bits)
+constexpr std::size_t batch_size = 1024u;
+
+// Adds the entropy at `first_num_bits + i` bits per paishan of every paishan
+// to `entropies[i]`, where `first_num_bits` is that of `contexts`.
+void accumulateEntropy(
+  std::vector<std::uint8_t> const &tiles,
+  std::vector<std::uint8_t> const &lengths,
+  std::vector<IsMajsoulFair::Interval> &intervals,
+  std::array<IsMajsoulFair::PaishanCodingContext, 2u> const &contexts,
+  std::vector<double> &entropies,
+  std::vector<double> &buffer)
 {
-  IsMajsoulFair::Interval const interval = IsMajsoulFair::permutationToInterval(paishan);
-  return IsMajsoulFair::intervalToEntropy(interval, num_bits);
+  std::span<std::uint8_t const> const rows(
+    tiles.data(), IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size());
+  // `intervals` outlives the frame, so it must be filled outside of it.
+  IsMajsoulFair::permutationToIntervalBatch(rows, lengths, intervals);
+
+  IsMajsoulFair::GmpArenaFrame const frame;
+  if (entropies.size() == 1u) {
+    for (std::size_t i = 0u; i < lengths.size(); ++i) {
+      IsMajsoulFair::PaishanCodingContext const &context
+        = lengths[i] == contexts.front().getLength() ? contexts.front() : contexts.back();
+      entropies.front() += IsMajsoulFair::intervalToEntropy(intervals[i], context);
+    }
+    return;
+  }
+  buffer.resize(entropies.size());
+  std::size_t const first_num_bits = contexts.front().getNumBits();
+  for (std::size_t i = 0u; i < lengths.size(); ++i) {
+    IsMajsoulFair::intervalToEntropies(intervals[i], first_num_bits, buffer);
+    for (std::size_t j = 0u; j < entropies.size(); ++j) {
+      entropies[j] += buffer[j];
+    }
+  }
 }
 
 } // namespace <unnamed>
 
 int main(int const argc, char const * const * const argv)
 {
-  if (argc != 3) {
-    std::cerr << "Usage: " << argv[0] << " <path to paishan file> <# of bits per paishan>" << std::endl;
+  if (argc != 3 && argc != 4) {
+    std::cerr << "Usage: " << argv[0]
+              << " <path to paishan file> <# of bits per paishan | first # of bits-last # of bits> [<# of threads>]"
+              << std::endl;
     return EXIT_FAILURE;
   }
 
-  std::filesystem::path const path(argv[1]);
-  std::ifstream ifs(path);
-  if (!ifs) {
-    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to open.";
-  }
+  IsMajsoulFair::installGmpArena();
 
-  std::size_t const num_bits = boost::lexical_cast<std::size_t>(argv[2]);
+  // The corpus is parsed on `num_threads` threads, zero meaning
+  // `std::thread::hardware_concurrency()`.
+  std::size_t const num_threads = argc == 4 ? boost::lexical_cast<std::size_t>(argv[3]) : 0u;
+  IsMajsoulFair::ParallelPaishanCorpusReader reader(argv[1], num_threads);
 
-  std::size_t num_paishan = 0u;
-  double entropy = 0.0;
-  while (true) {
-    std::string line;
-    std::getline(ifs, line);
-    if (ifs.bad()) {
-      IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to read.";
-    }
+  // A range of widths, `FIRST-LAST`, sweeps every width in it in one pass, and
+  // prints a table of the mean entropy per width.
+  std::string_view const widths(argv[2]);
+  std::size_t const separator = widths.find('-');
+  std::size_t const first_num_bits = boost::lexical_cast<std::size_t>(widths.substr(0u, separator));
+  std::size_t const last_num_bits = separator == std::string_view::npos
+    ? first_num_bits : boost::lexical_cast<std::size_t>(widths.substr(separator + 1u));
+  if (last_num_bits < first_num_bits) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << widths << ": An invalid range of the number of bits.";
+  }
 
-    if (!line.empty()) {
-      std::vector<std::uint_fast8_t> paishan;
-      for (auto e : line | std::ranges::views::split(',')) {
-        std::string_view sv{e.cbegin(), e.cend()};
-        unsigned const tile = boost::lexical_cast<unsigned>(sv);
-        if (tile >= 37u) {
-          IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << tile;
-        }
-        paishan.push_back(tile);
-      }
+  std::size_t num_paishan = 0u;
+  std::vector<double> entropies(last_num_bits - first_num_bits + 1u, 0.0);
+  std::vector<double> buffer;
+  std::vector<std::uint8_t> tiles(batch_size * IsMajsoulFair::permutation_to_interval_batch_stride);
+  std::vector<std::uint8_t> lengths;
+  lengths.reserve(batch_size);
+  std::vector<IsMajsoulFair::Interval> intervals;
+  // The contexts outlive every frame, so they must be built outside of them.
+  std::array<IsMajsoulFair::PaishanCodingContext, 2u> const contexts{
+    IsMajsoulFair::PaishanCodingContext(
+      IsMajsoulFair::FourPlayerTileSet(), IsMajsoulFair::FourPlayerTileSet::num_partial_tiles, first_num_bits),
+    IsMajsoulFair::PaishanCodingContext(
+      IsMajsoulFair::FourPlayerTileSet(), IsMajsoulFair::FourPlayerTileSet::num_tiles, first_num_bits)};
+  // Chunks come in the order of the corpus, so the sums are taken in the same
+  // order, and to the same bits, as on a single thread.
+  IsMajsoulFair::PaishanChunk chunk;
+  while (reader.next(chunk)) {
+    for (std::size_t i = 0u; i < chunk.getNumPaishan(); ++i) {
+      std::span<std::uint8_t const> const paishan = chunk.getPaishan(i);
       if (paishan.size() != 83u && paishan.size() != 136u) {
         IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << paishan.size();
       }
-
-      entropy += paishanToEntropy(paishan, num_bits);
+      std::copy(
+        paishan.begin(),
+        paishan.end(),
+        tiles.begin() + IsMajsoulFair::permutation_to_interval_batch_stride * lengths.size());
+      lengths.push_back(paishan.size());
       ++num_paishan;
-      continue;
-    }
-
-    if (ifs.eof()) {
-      break;
+      if (lengths.size() == batch_size) {
+        accumulateEntropy(tiles, lengths, intervals, contexts, entropies, buffer);
+        lengths.clear();
+      }
     }
-
-    IS_MAJSOUL_FAIR_THROW<std::runtime_error>(_1) << path.string() << ": Failed to read.";
   }
+  accumulateEntropy(tiles, lengths, intervals, contexts, entropies, buffer);
 
-  std::cout << entropy / num_paishan << std::endl;
+  if (separator == std::string_view::npos) {
+    std::cout << entropies.front() / num_paishan << std::endl;
+    return EXIT_SUCCESS;
+  }
+  for (std::size_t i = 0u; i < entropies.size(); ++i) {
+    std::cout << first_num_bits + i << ' ' << entropies[i] / num_paishan << '\n';
+  }
+  std::cout << std::flush;
 }
@@ -0,0 +1,71 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "core/multiset_permutation_rank.hpp"
+#include "core/paishan_corpus_reader.hpp"
+#include "core/integer.hpp"
+#include "common/throw.hpp"
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+// Writes `rank` as a line of hexadecimal digits, zero-padded to the width of
+// the largest rank.
+void writeRank(IsMajsoulFair::Integer const &rank, std::size_t const num_bits)
+{
+  std::size_t const num_digits = (num_bits + 3u) / 4u;
+  std::vector<unsigned char> bytes((num_digits + 1u) / 2u);
+  rank.exportBits(bytes.data(), 8u * bytes.size(), IsMajsoulFair::BitOrder::most_significant_first);
+
+  std::string line;
+  line.reserve(num_digits + 1u);
+  for (std::size_t i = 2u * bytes.size() - num_digits; i < 2u * bytes.size(); ++i) {
+    unsigned const digit = i % 2u == 0u ? bytes[i / 2u] >> 4u : bytes[i / 2u] & 0xFu;
+    line.push_back("0123456789abcdef"[digit]);
+  }
+  line.push_back('\n');
+  std::cout << line;
+}
+
+} // namespace <unnamed>
+
+int main(int const argc, char const * const * const argv)
+{
+  if (argc != 2) {
+    std::cerr << "Usage: " << argv[0] << " <PATH TO PAISHAN FILE>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  IsMajsoulFair::PaishanCorpusReader reader(argv[1]);
+
+  IsMajsoulFair::MultisetPermutationRanker const ranker;
+  std::size_t const num_bits = (ranker.getNumPermutations() - 1ul).bitLength();
+
+  std::vector<std::uint_fast8_t> paishan;
+  while (true) {
+    std::span<std::uint8_t const> const tiles = reader.next();
+    if (tiles.empty()) {
+      break;
+    }
+    if (tiles.size() != ranker.getLength()) {
+      IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << tiles.size() << ": Only full paishans can be ranked.";
+    }
+    paishan.assign(tiles.begin(), tiles.end());
+
+    writeRank(ranker.rank(paishan), num_bits);
+  }
+
+  std::cout << std::flush;
+}
@@ -0,0 +1,290 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "core/permutation_to_interval.hpp"
+#include "core/permutation_to_interval_batch.hpp"
+#include "core/covering_binary_interval.hpp"
+#include "core/tile_set.hpp"
+#include "core/interval.hpp"
+#include "core/fixed_integer.hpp"
+#include "core/integer.hpp"
+#include "common/throw.hpp"
+#include <boost/lexical_cast.hpp>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <string>
+#include <span>
+#include <vector>
+#include <array>
+#include <utility>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+#include <gmp.h>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+// Counts the allocations that GMP makes, and forwards them to the functions
+// that were installed before.
+std::atomic_size_t num_gmp_allocations(0u);
+
+void *(*base_allocate)(std::size_t) = nullptr;
+
+void *(*base_reallocate)(void *, std::size_t, std::size_t) = nullptr;
+
+void (*base_free)(void *, std::size_t) = nullptr;
+
+void *allocateCounting(std::size_t const size)
+{
+  num_gmp_allocations.fetch_add(1u, std::memory_order_relaxed);
+  return base_allocate(size);
+}
+
+void *reallocateCounting(void * const p, std::size_t const old_size, std::size_t const new_size)
+{
+  num_gmp_allocations.fetch_add(1u, std::memory_order_relaxed);
+  return base_reallocate(p, old_size, new_size);
+}
+
+void installCountingGmpAllocator()
+{
+  mp_get_memory_functions(&base_allocate, &base_reallocate, &base_free);
+  mp_set_memory_functions(&allocateCounting, &reallocateCounting, base_free);
+}
+
+// The value of `x` as the bytes of a 1536-bit integer, so that values of
+// different integer types can be compared.
+template<typename IntegerType>
+std::vector<unsigned char> toBytes(IntegerType const &x)
+{
+  std::vector<unsigned char> bytes(1536u / 8u);
+  x.exportBits(bytes.data(), 1536u, IsMajsoulFair::BitOrder::least_significant_first);
+  return bytes;
+}
+
+template<typename F>
+double measure(std::size_t const num_permutations, F &&f)
+{
+  auto const start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / num_permutations * 1.0e6;
+}
+
+} // namespace <unnamed>
+
+int main(int const argc, char const * const * const argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [<# OF THREADS>]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::size_t const num_threads = [&]() -> std::size_t {
+    if (argc == 2) {
+      std::size_t const num_threads = boost::lexical_cast<std::size_t>(argv[1]);
+      if (num_threads == 0u) {
+        return std::thread::hardware_concurrency();
+      }
+      return num_threads;
+    }
+    return std::thread::hardware_concurrency();
+  }();
+
+  installCountingGmpAllocator();
+
+  struct Case
+  {
+    std::string name;
+    std::array<std::uint_fast8_t, 37u> num_tiles;
+    std::size_t length;
+    // The batch encoder specialized on the tile set, if any, of the case.
+    void (*batch)(
+      std::span<std::uint8_t const>, std::span<std::uint8_t const>, std::vector<IsMajsoulFair::Interval> &);
+  };
+  using IsMajsoulFair::FourPlayerTileSet;
+  using IsMajsoulFair::ThreePlayerTileSet;
+  std::vector<Case> cases{
+    {"68 tiles (sanma)", ThreePlayerTileSet::num_tiles_per_code, ThreePlayerTileSet::num_partial_tiles,
+     &IsMajsoulFair::permutationToIntervalBatch<ThreePlayerTileSet>},
+    {"83 tiles", FourPlayerTileSet::num_tiles_per_code, FourPlayerTileSet::num_partial_tiles,
+     &IsMajsoulFair::permutationToIntervalBatch<FourPlayerTileSet>},
+    {"108 tiles (sanma)", ThreePlayerTileSet::num_tiles_per_code, ThreePlayerTileSet::num_tiles,
+     &IsMajsoulFair::permutationToIntervalBatch<ThreePlayerTileSet>},
+    {"136 tiles", FourPlayerTileSet::num_tiles_per_code, FourPlayerTileSet::num_tiles,
+     &IsMajsoulFair::permutationToIntervalBatch<FourPlayerTileSet>}};
+  // Synthetic multisets with every count of a paishan multiplied.
+  for (std::uint_fast8_t scale = 2u; scale <= 32u; scale *= 2u) {
+    std::array<std::uint_fast8_t, 37u> num_tiles = FourPlayerTileSet::num_tiles_per_code;
+    for (std::uint_fast8_t &num : num_tiles) {
+      num *= scale;
+    }
+    cases.push_back({std::to_string(136u * scale) + " tiles", num_tiles, 136u * scale, nullptr});
+  }
+
+  std::mt19937_64 urbg;
+  bool identical = true;
+  std::cout << "Microseconds per permutation (" << num_threads << " threads):" << std::endl;
+  std::cout << "  length, sequential, product tree, product tree (threads), batch" << std::endl;
+  for (Case const &c : cases) {
+    std::size_t const num_permutations = std::max<std::size_t>(4u, 400000u / (c.length * c.length / 64u + 1u));
+    std::vector<std::vector<std::uint_fast8_t>> permutations;
+    {
+      std::vector<std::uint_fast8_t> multiset;
+      for (std::uint_fast8_t tile = 0u; tile < c.num_tiles.size(); ++tile) {
+        multiset.insert(multiset.end(), c.num_tiles[tile], tile);
+      }
+      for (std::size_t i = 0u; i < num_permutations; ++i) {
+        std::shuffle(multiset.begin(), multiset.end(), urbg);
+        permutations.emplace_back(multiset.cbegin(), multiset.cbegin() + c.length);
+      }
+    }
+
+    std::vector<IsMajsoulFair::Interval> sequential;
+    std::vector<IsMajsoulFair::Interval> tree;
+    std::vector<IsMajsoulFair::Interval> threaded;
+    double const sequential_time = measure(num_permutations, [&]() {
+      for (std::vector<std::uint_fast8_t> const &permutation : permutations) {
+        sequential.push_back(IsMajsoulFair::permutationToInterval(permutation, c.num_tiles));
+      }
+    });
+    double const tree_time = measure(num_permutations, [&]() {
+      for (std::vector<std::uint_fast8_t> const &permutation : permutations) {
+        tree.push_back(IsMajsoulFair::permutationToIntervalByProductTree(permutation, c.num_tiles));
+      }
+    });
+    double const threaded_time = measure(num_permutations, [&]() {
+      for (std::vector<std::uint_fast8_t> const &permutation : permutations) {
+        threaded.push_back(IsMajsoulFair::permutationToIntervalByProductTree(permutation, c.num_tiles, num_threads));
+      }
+    });
+
+    std::vector<IsMajsoulFair::Interval> batch;
+    double batch_time = 0.0;
+    if (c.batch != nullptr) {
+      std::vector<std::uint8_t> tiles(IsMajsoulFair::permutation_to_interval_batch_stride * num_permutations);
+      std::vector<std::uint8_t> const lengths(num_permutations, c.length);
+      for (std::size_t i = 0u; i < num_permutations; ++i) {
+        std::copy(
+          permutations[i].cbegin(), permutations[i].cend(),
+          tiles.begin() + IsMajsoulFair::permutation_to_interval_batch_stride * i);
+      }
+      batch_time = measure(num_permutations, [&]() {
+        c.batch(tiles, lengths, batch);
+      });
+    }
+
+    for (std::size_t i = 0u; i < num_permutations; ++i) {
+      for (IsMajsoulFair::Interval const *interval : {&tree[i], &threaded[i]}) {
+        if (interval->getDenominator() != sequential[i].getDenominator()
+            || interval->getLowerNumerator() != sequential[i].getLowerNumerator()
+            || interval->getUpperNumerator() != sequential[i].getUpperNumerator()) {
+          identical = false;
+        }
+      }
+      if (c.batch != nullptr
+          && (batch[i].getDenominator() != sequential[i].getDenominator()
+              || batch[i].getLowerNumerator() != sequential[i].getLowerNumerator()
+              || batch[i].getUpperNumerator() != sequential[i].getUpperNumerator())) {
+        identical = false;
+      }
+    }
+
+    std::cout << "  " << c.name << ", " << sequential_time << ", " << tree_time << ", " << threaded_time << ", ";
+    if (c.batch != nullptr) {
+      std::cout << batch_time << std::endl;
+    }
+    else {
+      std::cout << '-' << std::endl;
+    }
+  }
+
+  // `FixedInteger<1536>` holds every value on the path of a 136-tile wall,
+  // including the numerators shifted by the width of the covering interval.
+  {
+    using FixedInteger = IsMajsoulFair::FixedInteger<1536u>;
+    constexpr std::size_t num_walls = 20000u;
+    constexpr std::size_t num_bits = 256u;
+
+    std::vector<std::vector<std::uint_fast8_t>> walls;
+    {
+      std::vector<std::uint_fast8_t> multiset;
+      for (std::uint_fast8_t tile = 0u; tile < FourPlayerTileSet::num_tiles_per_code.size(); ++tile) {
+        multiset.insert(multiset.end(), FourPlayerTileSet::num_tiles_per_code[tile], tile);
+      }
+      for (std::size_t i = 0u; i < num_walls; ++i) {
+        std::shuffle(multiset.begin(), multiset.end(), urbg);
+        walls.push_back(multiset);
+      }
+    }
+
+    std::vector<IsMajsoulFair::Interval> integer_intervals;
+    std::vector<IsMajsoulFair::BasicInterval<FixedInteger>> fixed_intervals;
+    std::vector<std::pair<IsMajsoulFair::Integer, IsMajsoulFair::Integer>> integer_covers;
+    std::vector<std::pair<FixedInteger, FixedInteger>> fixed_covers;
+    integer_intervals.reserve(num_walls);
+    fixed_intervals.reserve(num_walls);
+    integer_covers.reserve(num_walls);
+    fixed_covers.reserve(num_walls);
+
+    // Microseconds and GMP allocations per wall.
+    auto const measureAllocations = [&](auto &&f) {
+      std::size_t const num_allocations = num_gmp_allocations.load();
+      double const time = measure(num_walls, f);
+      return std::pair(time, static_cast<double>(num_gmp_allocations.load() - num_allocations) / num_walls);
+    };
+    auto const integer_interval = measureAllocations([&]() {
+      for (std::vector<std::uint_fast8_t> const &wall : walls) {
+        integer_intervals.push_back(IsMajsoulFair::permutationToInterval<IsMajsoulFair::Integer>(wall));
+      }
+    });
+    auto const fixed_interval = measureAllocations([&]() {
+      for (std::vector<std::uint_fast8_t> const &wall : walls) {
+        fixed_intervals.push_back(IsMajsoulFair::permutationToInterval<FixedInteger>(wall));
+      }
+    });
+    auto const integer_cover = measureAllocations([&]() {
+      for (IsMajsoulFair::Interval const &interval : integer_intervals) {
+        integer_covers.push_back(IsMajsoulFair::getCoveringBinaryInterval(interval, num_bits));
+      }
+    });
+    auto const fixed_cover = measureAllocations([&]() {
+      for (IsMajsoulFair::BasicInterval<FixedInteger> const &interval : fixed_intervals) {
+        fixed_covers.push_back(IsMajsoulFair::getCoveringBinaryInterval(interval, num_bits));
+      }
+    });
+
+    for (std::size_t i = 0u; i < num_walls; ++i) {
+      if (toBytes(integer_intervals[i].getDenominator()) != toBytes(fixed_intervals[i].getDenominator())
+          || toBytes(integer_intervals[i].getLowerNumerator()) != toBytes(fixed_intervals[i].getLowerNumerator())
+          || toBytes(integer_intervals[i].getUpperNumerator()) != toBytes(fixed_intervals[i].getUpperNumerator())
+          || toBytes(integer_covers[i].first) != toBytes(fixed_covers[i].first)
+          || toBytes(integer_covers[i].second) != toBytes(fixed_covers[i].second)) {
+        identical = false;
+      }
+    }
+
+    std::cout << "Microseconds and GMP allocations per 136-tile wall:" << std::endl;
+    std::cout << "  step, Integer, FixedInteger<1536>" << std::endl;
+    std::cout << "  permutationToInterval, " << integer_interval.first << " (" << integer_interval.second << "), "
+              << fixed_interval.first << " (" << fixed_interval.second << ')' << std::endl;
+    std::cout << "  getCoveringBinaryInterval, " << num_bits << " bits, " << integer_cover.first << " ("
+              << integer_cover.second << "), " << fixed_cover.first << " (" << fixed_cover.second << ')'
+              << std::endl;
+  }
+
+  if (!identical) {
+    std::cerr << "The product tree, the batch or FixedInteger disagrees with the sequential evaluation."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+}
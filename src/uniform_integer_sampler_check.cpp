@@ -0,0 +1,185 @@
+// Copyright (c) 2024 Cryolite
+// SPDX-License-Identifier: MIT
+// This file is part of https://github.com/Cryolite/is-majsoul-fair.
+
+#include "core/uniform_integer_sampler.hpp"
+#include "core/integer.hpp"
+#include "common/throw.hpp"
+#include <boost/math/distributions/chi_squared.hpp>
+#include <boost/lexical_cast.hpp>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <cstdint>
+#include <cstdlib>
+#include <cstddef>
+
+
+namespace{
+
+using std::placeholders::_1;
+
+IsMajsoulFair::Integer ceilDivide(IsMajsoulFair::Integer const &numerator, IsMajsoulFair::Integer const &denominator)
+{
+  IsMajsoulFair::Integer result = numerator + denominator;
+  result -= 1ul;
+  result /= denominator;
+  return result;
+}
+
+// Buckets samples from `[0, upper)` into `num_buckets` equal-width bins and
+// returns the p-value of the chi-squared test against the exact bin masses.
+double testBuckets(
+  IsMajsoulFair::IntegerRandomState &state,
+  IsMajsoulFair::Integer const &upper,
+  unsigned long const num_buckets,
+  unsigned long const num_samples)
+{
+  IsMajsoulFair::UniformIntegerSampler const sampler(upper);
+
+  std::vector<unsigned long> counts(num_buckets, 0u);
+  IsMajsoulFair::Integer sample;
+  for (unsigned long i = 0u; i < num_samples; ++i) {
+    sampler.sample(state, sample);
+    if (sample < 0l || sample >= upper) {
+      IS_MAJSOUL_FAIR_THROW<std::logic_error>("A sample is out of range.");
+    }
+    ++counts[static_cast<unsigned long>(sample * num_buckets / upper)];
+  }
+
+  double chi_square = 0.0;
+  for (unsigned long i = 0u; i < num_buckets; ++i) {
+    IsMajsoulFair::Integer const mass
+      = ceilDivide(upper * (i + 1u), IsMajsoulFair::Integer(num_buckets))
+      - ceilDivide(upper * i, IsMajsoulFair::Integer(num_buckets));
+    double const expected = IsMajsoulFair::divideAsDouble(mass, upper) * num_samples;
+    double const diff = static_cast<double>(counts[i]) - expected;
+    chi_square += diff * diff / expected;
+  }
+
+  boost::math::chi_squared_distribution<> distribution(static_cast<double>(num_buckets - 1u));
+  return 1.0 - boost::math::cdf(distribution, chi_square);
+}
+
+// The same as `testBuckets`, but bins by the residue modulo `num_buckets`,
+// which must divide `upper`, so that the low limbs are exercised.
+double testResidues(
+  IsMajsoulFair::IntegerRandomState &state,
+  IsMajsoulFair::Integer const &upper,
+  unsigned long const num_buckets,
+  unsigned long const num_samples)
+{
+  IsMajsoulFair::UniformIntegerSampler const sampler(upper);
+
+  std::vector<unsigned long> counts(num_buckets, 0u);
+  IsMajsoulFair::Integer sample;
+  for (unsigned long i = 0u; i < num_samples; ++i) {
+    sampler.sample(state, sample);
+    ++counts[static_cast<unsigned long>(sample % num_buckets)];
+  }
+
+  double chi_square = 0.0;
+  double const expected = static_cast<double>(num_samples) / num_buckets;
+  for (unsigned long const count : counts) {
+    double const diff = static_cast<double>(count) - expected;
+    chi_square += diff * diff / expected;
+  }
+
+  boost::math::chi_squared_distribution<> distribution(static_cast<double>(num_buckets - 1u));
+  return 1.0 - boost::math::cdf(distribution, chi_square);
+}
+
+template<typename F>
+double measure(unsigned long const num_samples, F &&f)
+{
+  auto const start = std::chrono::steady_clock::now();
+  f();
+  std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start;
+  return num_samples / elapsed.count();
+}
+
+} // namespace <unnamed>
+
+int main(int const argc, char const * const * const argv)
+{
+  if (argc > 2) {
+    std::cerr << "Usage: " << argv[0] << " [<# OF SAMPLES>]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  unsigned long const num_samples = argc == 2 ? boost::lexical_cast<unsigned long>(argv[1]) : 1000000u;
+  if (num_samples == 0u) {
+    IS_MAJSOUL_FAIR_THROW<std::invalid_argument>(_1) << num_samples << ": An invalid number of samples.";
+  }
+
+  IsMajsoulFair::Integer const one(1ul);
+  // The range `intervalToBinary` draws from with 632 bits per paishan.
+  IsMajsoulFair::Integer const paishan_range = (one << 632u) * IsMajsoulFair::Integer(136ul).pow(136u) / 3ul;
+
+  bool passed = true;
+  {
+    IsMajsoulFair::IntegerRandomState state({0x0123456789ABCDEFu, 0xFEDCBA9876543210u});
+    struct Case
+    {
+      std::string name;
+      IsMajsoulFair::Integer upper;
+      bool by_residue;
+    };
+    std::vector<Case> const cases{
+      {"7", IsMajsoulFair::Integer(7ul), false},
+      {"2^64 + 1", (one << 64u) + 1ul, false},
+      {"2^127 - 1", (one << 127u) - 1ul, false},
+      {"2^200 + 1", (one << 200u) + 1ul, false},
+      {"3 * 2^1405 (mod 16)", IsMajsoulFair::Integer(3ul) << 1405u, true},
+      {"paishan range", paishan_range, false}};
+    for (Case const &c : cases) {
+      unsigned long const num_buckets = c.upper < 64ul ? static_cast<unsigned long>(c.upper) : 64u;
+      double const p_value = c.by_residue
+        ? testResidues(state, c.upper, 16u, num_samples)
+        : testBuckets(state, c.upper, num_buckets, num_samples);
+      bool const ok = p_value > 1.0e-4;
+      passed = passed && ok;
+      std::cout << "[" << (ok ? "PASS" : "FAIL") << "] " << c.name << ": p_value = " << p_value << std::endl;
+    }
+  }
+
+  {
+    IsMajsoulFair::Integer sample;
+    IsMajsoulFair::UniformIntegerSampler const sampler(paishan_range);
+
+    IsMajsoulFair::IntegerRandomState mt_state;
+    double const mpz_urandomm_rate = measure(num_samples, [&]() {
+      for (unsigned long i = 0u; i < num_samples; ++i) {
+        sample.setToRandom(mt_state, paishan_range);
+      }
+    });
+    double const sampler_mt_rate = measure(num_samples, [&]() {
+      for (unsigned long i = 0u; i < num_samples; ++i) {
+        sampler.sample(mt_state, sample);
+      }
+    });
+
+    IsMajsoulFair::IntegerRandomState philox_state({1u, 0u});
+    double const sampler_philox_rate = measure(num_samples, [&]() {
+      for (unsigned long i = 0u; i < num_samples; ++i) {
+        sampler.sample(philox_state, sample);
+      }
+    });
+    std::vector<IsMajsoulFair::Integer> batch(1024u, paishan_range);
+    double const batch_philox_rate = measure(num_samples / batch.size() * batch.size(), [&]() {
+      for (unsigned long i = 0u; i < num_samples / batch.size(); ++i) {
+        sampler.sample(philox_state, batch);
+      }
+    });
+
+    std::cout << "Range of " << sampler.getNumBits() << " bits (samples/s):" << std::endl;
+    std::cout << "  mpz_urandomm (Mersenne Twister): " << mpz_urandomm_rate << std::endl;
+    std::cout << "  sampler (Mersenne Twister): " << sampler_mt_rate << std::endl;
+    std::cout << "  sampler (Philox): " << sampler_philox_rate << std::endl;
+    std::cout << "  sampler, batches of " << batch.size() << " (Philox): " << batch_philox_rate << std::endl;
+  }
+
+  return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}